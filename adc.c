@@ -8,15 +8,47 @@
  *  ------------
  *  This file configures and operates the ADC (Analog-to-Digital Converter)
  *  for the MSP430 microcontroller. It initializes the ADC, cycles through
- *  three analog input channels (left detector, right detector, and thumb),
- *  and stores the converted values. The ADC results are scaled and can be
+ *  the analog input channels (left detector, right detector, thumb and
+ *  the battery, 5 V and 3.3 V rails), and stores the converted values. The ADC results are scaled and can be
  *  converted to BCD format for display on an LCD.
  *
+ *  Conversions are started by the TB1.1 output, one every ADC_SLOT_US,
+ *  so the readings never go stale. The ISR picks the channel for the
+ *  next slot (adc.h) and counts the conversions that were lost because
+ *  it ran too late. Every ADC_OVERSAMPLE results of a channel are
+ *  summed into one value, filtered and published in adc_snap under a
+ *  sequence count. The two detectors are published together, so a
+ *  reader always gets a left and right from the same pass.
+ *
+ *  The ISR also owns the IR emitter. In ADC_IR_SYNC it turns the
+ *  emitter on or off as a new detector pair is programmed, a whole
+ *  slot before the first of the pair is sampled. On and off pairs are
+ *  summed apart, and a detector's value is full scale less what the
+ *  emitter alone pulled it down by. The detectors read higher over
+ *  black and in the dark, so the thresholds keep their meaning and the
+ *  room light drops out. The emitter is only lit for half the time.
+ *
+ *  Every conversion is also offered to capture.c, which keeps the raw
+ *  values while a capture is armed. The window comparator is set up
+ *  for each detector slot by edge.c and its interrupts go there.
+ *
+ *  Each filter runs a fixed number of steps per value. Its time is
+ *  measured from TB0R and the worst is sent in the status frame.
+ *
  *  Functions included:
- *    - Init_ADC: Initializes ADC settings and starts conversion.
+ *    - Init_ADC: Initializes ADC settings and arms the timer trigger.
  *    - HEXtoBCD: Converts a hexadecimal value to a 4-digit BCD format.
  *    - adc_line: Places BCD digits into the desired line and location on the display.
- *    - ADC_ISR: Handles ADC conversions and cycles through the input channels.
+ *    - adc_filter_value: Runs one value through a channel's filter.
+ *    - adc_publish: Filters a decimated value and updates the snapshot.
+ *    - adc_accumulate: Sums one conversion, emitter on or off.
+ *    - adc_read: Copies a coherent snapshot for the main loop.
+ *    - adc_set_filter: Selects the filter of a channel.
+ *    - adc_set_slot: Changes the time between conversions.
+ *    - IR_LED_control: Selects how the IR emitter is driven.
+ *    - adc_next_slot: Picks the channel and emitter state for the next slot.
+ *    - ADC_ISR: Accumulates each result, selects the channel for the next slot
+ *      and passes window comparator crossings to edge.c.
  *
  */
 
@@ -27,12 +59,49 @@
 #include  "LCD.h"
 #include  "ports.h"
 #include "macros.h"
+#include "power.h"
+#include "isrprof.h"
+#include "timebase.h"
+#include "adc.h"
+#include "capture.h"
+#include "edge.h"
 
 unsigned int ADC_Channel;
 unsigned int ADC_Left_Det;
 unsigned int ADC_Right_Det;
 unsigned int ADC_Thumb;
 
+volatile adc_snapshot adc_snap;         // Published values, read with adc_read()
+adc_snapshot adc_work;                  // Next snapshot, copied into adc_snap
+unsigned int adc_left_value;            // Left detector waiting for its pair
+unsigned int adc_left_ambient;
+unsigned long adc_left_stamp;
+adc_filter adc_filters[ADC_CHANNELS];
+volatile unsigned char adc_filter_kind[ADC_CHANNELS];  // Requested, the ISR switches over
+unsigned long adc_acc[ADC_CHANNELS];    // Conversions summed so far
+unsigned char adc_acc_count[ADC_CHANNELS];
+unsigned long adc_acc_off[ADC_DETECTORS];  // Emitter off, ADC_IR_SYNC
+unsigned char adc_acc_off_count[ADC_DETECTORS];
+volatile unsigned char adc_ir_mode;
+volatile unsigned char adc_ir_request;  // Taken up at the start of the next pair
+unsigned char adc_led_off;              // Conversion in flight has the emitter off
+volatile unsigned int adc_missed;
+volatile unsigned int adc_filter_worst;
+unsigned int adc_slot;                  // Slots since the last thumbwheel sample
+unsigned int adc_line_next;             // Detector for the next line slot
+unsigned int adc_rail_slot;             // Slots since a rail was last due
+unsigned char adc_rail_due;             // A rail is waiting for a free slot
+unsigned char adc_rail_next;            // Rail for the next rail slot
+
+const unsigned int adc_inch[ADC_CHANNELS] = {
+    ADCINCH_2,                          // ADC_LEFT
+    ADCINCH_3,                          // ADC_RIGHT
+    ADCINCH_5,                          // ADC_THUMB
+    ADCINCH_8,                          // ADC_VBAT
+    ADCINCH_9,                          // ADC_V5_0
+    ADCINCH_11,                         // ADC_V3_3
+};
+
 char display_line[4][11];
 volatile unsigned char display_changed;
 unsigned int adc_char[4];
@@ -91,22 +160,25 @@ void Init_ADC(void) {
   // V_DETECT_L (0x04) // Pin 2 A2
   // V_DETECT_R (0x08) // Pin 3 A3
   // V_THUMB    (0x20) // Pin 5 A5
+  // V_BAT      (0x01) // P5.0 A8
+  // V_5_0      (0x02) // P5.1 A9
+  // V_3_3      (0x08) // P5.3 A11
   //------------------------------------------------------------------------------
 
   // ADCCTL0 Register
   ADCCTL0 = 0;                  // Reset
   ADCCTL0 |= ADCSHT_2;         // 16 ADC clocks
-  ADCCTL0 |= ADCMSC;           // MSC
+  ADCCTL0 &= ~ADCMSC;          // One conversion per trigger edge
   ADCCTL0 |= ADCON;            // ADC ON
 
   // ADCCTL1 Register
   ADCCTL1 = 0;                 // Reset
-  ADCCTL1 |= ADCSHS_0;         // 00b = ADCSC bit
+  ADCCTL1 |= ADCSHS_1;         // 01b = TB1.1B, see Init_Timer_B1
   ADCCTL1 |= ADCSHP;           // ADC sample-and-hold SAMPCON signal from sampling timer.
   ADCCTL1 &= ~ADCISSH;         // ADC invert signal sample-and-hold.
   ADCCTL1 |= ADCDIV_0;         // ADC clock divider - 000b = Divide by 1
   ADCCTL1 |= ADCSSEL_0;        // ADC clock MODCLK
-  ADCCTL1 |= ADCCONSEQ_0;      // ADC conversion sequence 00b = Single-channel single-conversion
+  ADCCTL1 |= ADCCONSEQ_2;      // ADC conversion sequence 10b = Repeat-single-channel
   // ADCCTL1 & ADCBUSY identifies a conversion is in process
 
   // ADCCTL2 Register
@@ -117,77 +189,320 @@ void Init_ADC(void) {
   ADCCTL2 &= ~ADCSR;           // ADC sampling rate 0b = ADC buffer supports up to 200 ksps
 
   // ADCMCTL0 Register
-  ADCMCTL0 |= ADCSREF_0;       // VREF - 000b = {VR+ = AVCC and VR– = AVSS }
-  ADCMCTL0 |= ADCINCH_5;       // V_THUMB (0x20) Pin 5 A5
+  memset(adc_filters, 0, sizeof(adc_filters));
+  memset(adc_acc, 0, sizeof(adc_acc));
+  memset(adc_acc_count, 0, sizeof(adc_acc_count));
+  adc_filter_kind[ADC_LEFT] = ADC_FILTER_MEDIAN;   // Rejects single spikes, keeps edges
+  adc_filter_kind[ADC_RIGHT] = ADC_FILTER_MEDIAN;
+  adc_filter_kind[ADC_THUMB] = ADC_FILTER_AVG;
+  adc_filter_kind[ADC_VBAT] = ADC_FILTER_AVG;    // Motor current ripple on the rails
+  adc_filter_kind[ADC_V5_0] = ADC_FILTER_AVG;
+  adc_filter_kind[ADC_V3_3] = ADC_FILTER_AVG;
+  adc_rail_slot = 0;
+  adc_rail_due = FALSE;
+  adc_rail_next = ADC_VBAT;
+  adc_filter_worst = 0;
+  adc_ir_mode = ADC_IR_ON;              // The first pair switches to adc_ir_request
+  adc_ir_request = ADC_IR_DEFAULT;
+  adc_led_off = FALSE;
+  P2OUT |= IR_LED;
+  ADC_Channel = ADC_LEFT;
+  adc_line_next = ADC_RIGHT;
+  adc_slot = 0;
+  adc_missed = 0;
+  ADCMCTL0 = ADCSREF_0;        // VREF - 000b = {VR+ = AVCC and VR– = AVSS }
+  ADCMCTL0 |= adc_inch[ADC_Channel];   // V_DETECT_L (0x04) Pin 2 A2
 
   ADCIE |= ADCIE0;             // Enable ADC conv complete interrupt
-  ADCCTL0 |= ADCENC;           // ADC enable conversion.
-  ADCCTL0 |= ADCSC;            // ADC start conversion.
+  ADCIE |= ADCOVIE | ADCTOVIE; // Lost conversions, counted in adc_missed
+  ADCHI = 0x0FFF;              // Window comparator, loaded for each detector slot by edge_window
+  ADCLO = 0;
+  ADCCTL0 |= ADCENC;           // ADC enable conversion, TB1.1 starts each one
+}
+//-------------------------------------------------------------
+
+//-------------------------------------------------------------
+// One decimated value through a channel's filter. A new filter
+// kind starts with its history full of the current value. The
+// history and sum are kept whatever the kind, then at most
+// ADC_MEDIAN_LEN - 1 insertion passes for the median.
+//-------------------------------------------------------------
+static unsigned int adc_filter_value(unsigned char channel, unsigned int x){
+  adc_filter *f = &adc_filters[channel];
+  unsigned int sorted[ADC_MEDIAN_LEN];
+  unsigned int v;
+  unsigned char i;
+  unsigned char j;
+
+  if(!f->primed || f->kind != adc_filter_kind[channel]){
+    f->kind = adc_filter_kind[channel];
+    for(i = 0; i < ADC_HIST_LEN; i++){
+      f->hist[i] = x;
+    }
+    f->sum = (unsigned long)x << ADC_HIST_SHIFT;
+    f->iir = (unsigned long)x << ADC_IIR_SHIFT;
+    f->pos = 0;
+    f->primed = TRUE;
+    return x;
+  }
+
+  f->sum -= f->hist[f->pos];
+  f->sum += x;
+  f->hist[f->pos] = x;
+  f->pos = (f->pos + 1) & (ADC_HIST_LEN - 1);
+
+  switch(f->kind){
+    case ADC_FILTER_AVG:
+      return f->sum >> ADC_HIST_SHIFT;
+
+    case ADC_FILTER_IIR:
+      f->iir -= f->iir >> ADC_IIR_SHIFT;
+      f->iir += x;
+      return f->iir >> ADC_IIR_SHIFT;
+
+    case ADC_FILTER_MEDIAN:
+      for(i = 0; i < ADC_MEDIAN_LEN; i++){
+        v = f->hist[(f->pos - 1 - i) & (ADC_HIST_LEN - 1)];
+        for(j = i; j && sorted[j - 1] > v; j--){
+          sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+      }
+      return sorted[ADC_MEDIAN_LEN / 2];
+
+    default:
+      return x;
+  }
+}
+
+//-------------------------------------------------------------
+// Called from ADC_ISR with a decimated value and its ambient part.
+// The left detector is held back until the right one is done.
+//-------------------------------------------------------------
+static void adc_publish(unsigned char channel, unsigned int x, unsigned int ambient, unsigned long stamp){
+  unsigned int start;
+  unsigned int us;
+  unsigned char i;
+
+  start = TB0R;
+  x = adc_filter_value(channel, x);
+  us = TB0R - start;
+  if(us > adc_filter_worst){
+    adc_filter_worst = us;
+  }
+  if(channel == ADC_LEFT){
+    adc_left_value = x;
+    adc_left_ambient = ambient;
+    adc_left_stamp = stamp;
+    return;
+  }
+  if(channel == ADC_RIGHT){
+    adc_work.value[ADC_LEFT] = adc_left_value;
+    adc_work.ambient[ADC_LEFT] = adc_left_ambient;
+    adc_work.stamp[ADC_LEFT] = adc_left_stamp;
+  }
+  adc_work.value[channel] = x;
+  adc_work.ambient[channel] = ambient;
+  adc_work.stamp[channel] = stamp;
+
+  adc_snap.seq++;                       // Odd, readers retry
+  for(i = 0; i < ADC_CHANNELS; i++){
+    adc_snap.value[i] = adc_work.value[i];
+    adc_snap.ambient[i] = adc_work.ambient[i];
+    adc_snap.stamp[i] = adc_work.stamp[i];
+  }
+  adc_snap.seq++;
+
+  // 10 bit copies for the display and menu
+  ADC_Left_Det = adc_work.value[ADC_LEFT] >> (ADC_SNAP_BITS - 10);
+  ADC_Right_Det = adc_work.value[ADC_RIGHT] >> (ADC_SNAP_BITS - 10);
+  ADC_Thumb = adc_work.value[ADC_THUMB] >> (ADC_SNAP_BITS - 10);
+  if(channel == ADC_RIGHT){
+    POWER_WAKE();                       // Both detectors are new
+  }
+}
+
+//-------------------------------------------------------------
+// One conversion of a channel, emitter on or off. Detectors in
+// ADC_IR_SYNC are published once both halves are complete. Only
+// SYNC has halves, in ADC_IR_OFF every conversion is dark and goes
+// in the main sum like the other modes.
+//-------------------------------------------------------------
+static void adc_accumulate(unsigned char channel, unsigned int result, unsigned char off){
+  unsigned int on_value;
+  unsigned int off_value;
+  unsigned int lit;
+
+  if(off && channel < ADC_DETECTORS && adc_ir_mode == ADC_IR_SYNC){
+    adc_acc_off[channel] += result;
+    adc_acc_off_count[channel]++;
+  } else {
+    adc_acc[channel] += result;
+    adc_acc_count[channel]++;
+  }
+  if(adc_acc_count[channel] < ADC_OVERSAMPLE){
+    return;
+  }
+  on_value = ADC_DECIMATE(adc_acc[channel]);
+
+  if(channel >= ADC_DETECTORS || adc_ir_mode == ADC_IR_ON){
+    adc_publish(channel, on_value, 0, now_us());
+  } else if(adc_ir_mode == ADC_IR_OFF){
+    adc_publish(channel, on_value, ADC_SNAP_FULL - on_value, now_us());
+  } else {
+    if(adc_acc_off_count[channel] < ADC_OVERSAMPLE){
+      return;                           // Off half still to come
+    }
+    off_value = ADC_DECIMATE(adc_acc_off[channel]);
+    lit = off_value > on_value ? off_value - on_value : 0;
+    adc_publish(channel, ADC_SNAP_FULL - lit, ADC_SNAP_FULL - off_value, now_us());
+    adc_acc_off[channel] = 0;
+    adc_acc_off_count[channel] = 0;
+  }
+  adc_acc[channel] = 0;
+  adc_acc_count[channel] = 0;
+}
+
+//-------------------------------------------------------------
+// Main loop side. Copies again if ADC_ISR published while the copy
+// was being made.
+//-------------------------------------------------------------
+void adc_read(adc_snapshot *snap){
+  unsigned int seq;
+  unsigned char i;
+
+  do {
+    seq = adc_snap.seq;
+    for(i = 0; i < ADC_CHANNELS; i++){
+      snap->value[i] = adc_snap.value[i];
+      snap->stamp[i] = adc_snap.stamp[i];
+      snap->ambient[i] = adc_snap.ambient[i];
+    }
+  } while((seq & 1) || seq != adc_snap.seq);
+  snap->seq = seq;
+}
+
+void IR_LED_control(char selection){
+  if(selection >= ADC_IR_OFF && selection < ADC_IR_COUNT){
+    adc_ir_request = selection;
+  }
+}
+
+//-------------------------------------------------------------
+// Next slot. The thumbwheel takes every ADC_THUMB_SLOTS-th slot and
+// a rail the first free one after every ADC_RAIL_SLOTS-th, the
+// detectors alternate in the rest. A new detector pair is where
+// the emitter mode changes and where ADC_IR_SYNC flips it.
+//-------------------------------------------------------------
+static void adc_next_slot(void){
+  if(++adc_rail_slot >= ADC_RAIL_SLOTS){
+    adc_rail_slot = 0;
+    adc_rail_due = TRUE;
+  }
+  if(++adc_slot >= ADC_THUMB_SLOTS){
+    adc_slot = 0;
+    ADC_Channel = ADC_THUMB;
+    return;
+  }
+  if(adc_rail_due){
+    adc_rail_due = FALSE;
+    ADC_Channel = adc_rail_next;
+    adc_rail_next = (adc_rail_next == ADC_V3_3) ? ADC_VBAT : adc_rail_next + 1;
+    return;
+  }
+  ADC_Channel = adc_line_next;
+  adc_line_next = (adc_line_next == ADC_LEFT) ? ADC_RIGHT : ADC_LEFT;
+  if(ADC_Channel != ADC_LEFT){
+    return;
+  }
+
+  if(adc_ir_mode != adc_ir_request){
+    adc_ir_mode = adc_ir_request;
+    memset(adc_acc, 0, sizeof(adc_acc[0]) * ADC_DETECTORS);   // Halves from the old mode
+    memset(adc_acc_count, 0, ADC_DETECTORS);
+    memset(adc_acc_off, 0, sizeof(adc_acc_off));
+    memset(adc_acc_off_count, 0, sizeof(adc_acc_off_count));
+    adc_led_off = TRUE;                 // SYNC starts with an on pair
+  }
+  if(adc_ir_mode == ADC_IR_SYNC){
+    adc_led_off = !adc_led_off;
+  } else {
+    adc_led_off = adc_ir_mode == ADC_IR_OFF;
+  }
+  if(adc_led_off){
+    P2OUT &= ~IR_LED;
+  } else {
+    P2OUT |= IR_LED;
+  }
+}
+
+void adc_set_filter(unsigned char channel, unsigned char kind){
+  if(channel < ADC_CHANNELS && kind < ADC_FILTER_COUNT){
+    adc_filter_kind[channel] = kind;    // Taken up with the channel's next value
+  }
+}
+
+//-------------------------------------------------------------
+// New TB1 period, for capture.c. A period shorter than TB1R just
+// rolls the count to zero, at worst one slot is lost. The thumb
+// and rail slot counts stay the same, so they run faster too.
+//-------------------------------------------------------------
+void adc_set_slot(unsigned int us){
+  TB1CCR1 = us / 2;
+  TB1CCR0 = us - 1;
 }
 
 #pragma vector=ADC_VECTOR
 __interrupt void ADC_ISR(void) {
+  unsigned char channel;
+  unsigned char off;
+  unsigned int result;
+  ISR_PROF_ENTER(ISR_PROF_ADC);
   switch(__even_in_range(ADCIV, ADCIV_ADCIFG)) {
     case ADCIV_NONE:
       break;
 
     case ADCIV_ADCOVIFG:       // When a conversion result is written to the ADCMEM0
                                // before its previous conversion result was read.
+      adc_missed++;
       break;
 
-    case ADCIV_ADCTOVIFG:      // ADC conversion-time overflow
+    case ADCIV_ADCTOVIFG:      // ADC conversion-time overflow, a trigger came
+      adc_missed++;            // while the last conversion was still running
       break;
 
-    case ADCIV_ADCHIIFG:       // Window comparator interrupt flags
+    case ADCIV_ADCHIIFG:       // Window comparator, result above ADCHI, see edge_window
+      edge_crossing(TRUE);
       break;
 
-    case ADCIV_ADCLOIFG:       // Window comparator interrupt flag
+    case ADCIV_ADCLOIFG:       // Window comparator, result below ADCLO
+      edge_crossing(FALSE);
       break;
 
-    case ADCIV_ADCINIFG:       // Window comparator interrupt flag
-      break;
+    case ADCIV_ADCINIFG:       // Window comparator, in the band. Never enabled, the
+      break;                   // detector keeps its state inside the hysteresis
 
     case ADCIV_ADCIFG:         // ADCMEM0 memory register with the conversion result
-      ADCCTL0 &= ~ADCENC;      // Disable ENC bit.
-
-      switch (ADC_Channel++) {
-        case 0x00: {
-          ADC_Left_Det = ADCMEM0;           // Move result into Global
-          ADC_Left_Det = ADC_Left_Det >> 2; // Divide the result by 4
-
-          ADCMCTL0 &= ~ADCINCH_2;              // Disable Last channel A2
-          ADCMCTL0 |= ADCINCH_3;               // Enable Next channel A3
-        } break;
-
-        case 0x01: {                            // ADC_Right_Det
-          ADC_Right_Det = ADCMEM0;          // Move result into Global
-          ADC_Right_Det = ADC_Right_Det >> 2; // Divide the result by 4
+      ADCCTL0 &= ~ADCENC;      // Disable ENC bit, ADCINCH can only change while it is off.
 
-          ADCMCTL0 &= ~ADCINCH_3;              // Disable Last channel A2
-          ADCMCTL0 |= ADCINCH_5;               // Enable Next channel A3
-        } break;
+      channel = ADC_Channel;
+      off = adc_led_off;
+      result = ADCMEM0;
 
-        case 0x02: {
-          ADC_Thumb = ADCMEM0;                 // Move result into Global
-          ADC_Thumb = ADC_Thumb >> 2;          // Divide the result by 4
-
-          ADCMCTL0 &= ~ADCINCH_5;              // Disable Last channel A2
-          ADCMCTL0 |= ADCINCH_2;               // Enable Next channel A3
-
-          ADC_Channel = 0;                     // Reset channel index
-          // Do not start the next sample
-        } break;
-
-        default:
-          break;
-      }
+      adc_next_slot();
+      ADCMCTL0 = ADCSREF_0 | adc_inch[ADC_Channel];
+      edge_window(ADC_Channel, adc_led_off,
+                  adc_ir_mode == ADC_IR_SYNC ? adc_work.ambient[ADC_Channel] : 0);
+      ADCCTL0 |= ADCENC; // Enable Conversions, the next TB1.1 edge starts it
 
-      ADCCTL0 |= ADCENC; // Enable Conversions
+      adc_accumulate(channel, result, off);
+      capture_sample(channel, result, off);
       break;
 
     default:
       break;
   }
+  ISR_PROF_EXIT(ISR_PROF_ADC);
 }
 
 
@@ -0,0 +1,123 @@
+/*
+ * adc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  ADC sampling schedule. TB1.1 triggers one conversion every
+ *  ADC_SLOT_US. The slots alternate between the two line detectors
+ *  and every ADC_THUMB_SLOTS-th one goes to the thumbwheel instead.
+ *  Every ADC_RAIL_SLOTS-th slot (or the next one, if the thumbwheel has
+ *  it) samples one of the supply rails, in turn.
+ *
+ *  ADC_OVERSAMPLE conversions of a channel are summed and decimated,
+ *  run through that channel's filter and published in adc_snap. Read
+ *  it with adc_read(), which never returns a half-updated snapshot.
+ *
+ *  In ADC_IR_SYNC the IR emitter is switched at the start of every
+ *  detector pair, so the pairs alternate between emitter on and off.
+ *  The difference is what the emitter alone does; the off reading is
+ *  the ambient light.
+ *  Include after timebase.h.
+ */
+
+#ifndef ADC_H_
+#define ADC_H_
+
+// Channels, index of adc_snapshot.value[]
+#define ADC_LEFT            (0)     // V_DETECT_L, A2
+#define ADC_RIGHT           (1)     // V_DETECT_R, A3
+#define ADC_THUMB           (2)     // V_THUMB, A5
+#define ADC_VBAT            (3)     // V_BAT, P5.0 A8
+#define ADC_V5_0            (4)     // V_5_0, P5.1 A9
+#define ADC_V3_3            (5)     // V_3_3, P5.3 A11
+#define ADC_CHANNELS        (6)
+#define ADC_DETECTORS       (2)     // ADC_LEFT and ADC_RIGHT, the first channels
+#define ADC_RAILS           (3)     // ADC_VBAT to ADC_V3_3
+
+#ifndef ADC_SLOT_US
+#define ADC_SLOT_US         (250)   // us between conversions, each detector every 2 slots
+#endif
+#ifndef ADC_THUMB_MS
+#define ADC_THUMB_MS        (25)    // ms between thumbwheel conversions
+#endif
+#define ADC_THUMB_SLOTS     ((ADC_THUMB_MS * 1000UL) / ADC_SLOT_US)
+#ifndef ADC_RAIL_MS
+#define ADC_RAIL_MS         (20)    // ms between rail conversions, each rail every 3
+#endif
+#define ADC_RAIL_SLOTS      ((ADC_RAIL_MS * 1000UL) / ADC_SLOT_US)
+
+
+//------------------------------------------------------------------------------
+// Oversampling. 4^n conversions give n more bits, as long as there is
+// at least an LSB of noise on the input. Published values are always
+// ADC_SNAP_BITS wide, whatever n is.
+//------------------------------------------------------------------------------
+#ifndef ADC_OVERSAMPLE_BITS
+#define ADC_OVERSAMPLE_BITS (1)     // 0 to 2, so 12 to 14 bits
+#endif
+#define ADC_OVERSAMPLE      (1 << (2 * ADC_OVERSAMPLE_BITS))
+#define ADC_SNAP_BITS       (14)
+#define ADC_SNAP_FULL       (4095 << 2)             // Full scale at ADC_SNAP_BITS
+#define ADC_DECIMATE(sum)   ((unsigned int)((sum) >> ADC_OVERSAMPLE_BITS) << (2 - ADC_OVERSAMPLE_BITS))
+#define ADC_FROM_10BIT(v)   ((v) << (ADC_SNAP_BITS - 10))
+#define LINE_THRESHOLD      ADC_FROM_10BIT(600)     // Detector over black, was 600 of 1023
+
+// Filters, selected per channel with adc_set_filter() or ^0000A<ch>,<filter>
+#define ADC_FILTER_NONE     (0)
+#define ADC_FILTER_AVG      (1)     // Moving average of ADC_HIST_LEN values
+#define ADC_FILTER_IIR      (2)     // y += (x - y) / 2^ADC_IIR_SHIFT
+#define ADC_FILTER_MEDIAN   (3)     // Median of the last ADC_MEDIAN_LEN values
+#define ADC_FILTER_COUNT    (4)
+#define ADC_HIST_SHIFT      (3)
+#define ADC_HIST_LEN        (1 << ADC_HIST_SHIFT)
+#define ADC_IIR_SHIFT       (2)
+#define ADC_MEDIAN_LEN      (5)     // Odd, at most ADC_HIST_LEN
+
+// IR emitter modes, IR_LED_control() or ^0000I<mode>
+#define ADC_IR_OFF          (0)     // Emitter off, detectors only see ambient light
+#define ADC_IR_ON           (1)     // Emitter always on, no ambient figure
+#define ADC_IR_SYNC         (2)     // Emitter on and off in turn, difference published
+#define ADC_IR_COUNT        (3)
+#ifndef ADC_IR_DEFAULT
+#define ADC_IR_DEFAULT      ADC_IR_SYNC
+#endif
+
+#if ADC_OVERSAMPLE_BITS < 0 || ADC_OVERSAMPLE_BITS > 2
+#error "ADC_OVERSAMPLE_BITS must be 0 to 2"
+#endif
+#if ADC_SLOT_US < 100 || ADC_SLOT_US > 65535
+#error "ADC_SLOT_US must be 100 to 65535"
+#endif
+#if ADC_THUMB_SLOTS < 3
+#error "ADC_THUMB_MS must be at least three ADC slots"
+#endif
+#if ADC_RAIL_SLOTS < 3
+#error "ADC_RAIL_MS must be at least three ADC slots"
+#endif
+
+typedef struct {
+    unsigned int value[ADC_CHANNELS];   // Filtered, ADC_SNAP_BITS wide
+    unsigned long stamp[ADC_CHANNELS];  // now_us() of the last conversion in each value
+    unsigned int ambient[ADC_CHANNELS]; // Drop from full scale with the emitter off, 0 in ADC_IR_ON
+    unsigned int seq;                   // Odd while the ISR is writing
+} adc_snapshot;
+
+typedef struct {
+    unsigned char kind;             // ADC_FILTER_...
+    unsigned char primed;           // History holds real samples
+    unsigned char pos;              // Next hist[] entry to write
+    unsigned int hist[ADC_HIST_LEN];
+    unsigned long sum;              // Sum of hist[]
+    unsigned long iir;              // IIR output << ADC_IIR_SHIFT
+} adc_filter;
+
+extern volatile unsigned int adc_missed;            // Conversions lost, see ADC_ISR
+extern volatile unsigned int adc_filter_worst;      // Longest filter run in us, cleared by telemetry
+extern volatile unsigned char adc_ir_mode;          // ADC_IR_..., the one in use
+
+void adc_read(adc_snapshot *snap);
+void adc_set_filter(unsigned char channel, unsigned char kind);
+void adc_set_slot(unsigned int us);
+
+#endif /* ADC_H_ */
@@ -0,0 +1,125 @@
+/*
+ * battery.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file turns the filtered V_BAT, V_5_0 and V_3_3 readings into
+ *  millivolts and watches the battery. Below BAT_LOW_MV the battery is
+ *  flagged low until it comes back over BAT_OK_MV, and every change is
+ *  sent as a battery telemetry frame.
+ *
+ *  As the pack drains the same duty gives the motors less voltage, so
+ *  speeds and timed turns drift. With compensation on (^0000V1) every
+ *  duty written by wheels.c goes through motor_duty(), which scales it
+ *  by BAT_NOMINAL_MV / V_BAT so the average motor voltage stays where
+ *  the duties were tuned.
+ *
+ *  Functions included:
+ *    - Init_Battery: Starts with nominal readings and no compensation.
+ *    - Battery_Process: Updates the rails, the low flag and the scale.
+ *    - battery_report: Sends the battery telemetry frame.
+ *    - battery_compensation: Turns duty compensation on or off.
+ *    - motor_duty: Scales a TB3 duty for the battery voltage.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "ports.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "adc.h"
+#include "battery.h"
+
+const unsigned int rail_full_mv[ADC_RAILS] = {
+    BAT_FULL_MV,                        // ADC_VBAT
+    RAIL_5_0_FULL_MV,                   // ADC_V5_0
+    RAIL_3_3_FULL_MV,                   // ADC_V3_3
+};
+
+unsigned int rail_mv[ADC_RAILS];
+char bat_low;
+char bat_comp_on;
+char bat_report_due;                    // Low flag changed, frame not sent yet
+unsigned int bat_comp;
+
+void battery_report(void);
+
+void Init_Battery(void){
+    memset(rail_mv, 0, sizeof(rail_mv));
+    bat_low = FALSE;
+    bat_report_due = FALSE;
+    bat_comp = BAT_COMP_ONE;
+    bat_comp_on = BAT_COMP_DEFAULT;
+}
+
+void Battery_Process(void){
+    adc_snapshot snap;
+    unsigned long comp;
+    unsigned char i;
+
+    if(bat_report_due){
+        battery_report();               // Transmitter was busy last time
+    }
+    adc_read(&snap);
+    if(!snap.stamp[ADC_VBAT]){
+        return;                         // No battery reading yet
+    }
+    for(i = 0; i < ADC_RAILS; i++){
+        rail_mv[i] = ((unsigned long)snap.value[ADC_VBAT + i] * rail_full_mv[i]) / ADC_SNAP_FULL;
+    }
+
+    if(!bat_low && rail_mv[RAIL_BAT] < BAT_LOW_MV){
+        bat_low = TRUE;
+        battery_report();
+    } else if(bat_low && rail_mv[RAIL_BAT] > BAT_OK_MV){
+        bat_low = FALSE;
+        battery_report();
+    }
+
+    if(!bat_comp_on || !rail_mv[RAIL_BAT]){
+        bat_comp = BAT_COMP_ONE;
+        return;
+    }
+    comp = ((unsigned long)BAT_NOMINAL_MV << BAT_COMP_SHIFT) / rail_mv[RAIL_BAT];
+    if(comp < BAT_COMP_MIN){
+        comp = BAT_COMP_MIN;
+    } else if(comp > BAT_COMP_MAX){
+        comp = BAT_COMP_MAX;
+    }
+    bat_comp = comp;
+}
+
+void battery_report(void){
+    unsigned char payload[TLM_BATTERY_LEN];
+
+    put_u16(&payload[TLM_BAT_MV], rail_mv[RAIL_BAT]);
+    put_u16(&payload[TLM_BAT_5_0], rail_mv[RAIL_5_0]);
+    put_u16(&payload[TLM_BAT_3_3], rail_mv[RAIL_3_3]);
+    payload[TLM_BAT_LOW] = bat_low;
+    put_u16(&payload[TLM_BAT_COMP], bat_comp);
+    bat_report_due = !telemetry_send(TLM_TYPE_BATTERY, payload, TLM_BATTERY_LEN);
+}
+
+void battery_compensation(char on){
+    bat_comp_on = on;
+    if(!on){
+        bat_comp = BAT_COMP_ONE;
+    }
+}
+
+//-----------------------------------------------------------------
+// Duty for TB3 at the present battery voltage, never more than the
+// whole period. Off stays off.
+//-----------------------------------------------------------------
+unsigned int motor_duty(unsigned int duty){
+    unsigned long scaled = ((unsigned long)duty * bat_comp) >> BAT_COMP_SHIFT;
+
+    return scaled > WHEEL_PERIOD ? WHEEL_PERIOD : scaled;
+}
@@ -0,0 +1,52 @@
+/*
+ * battery.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Battery and supply rail monitor. The rails come from the ADC
+ *  snapshot (adc.h) and are kept in millivolts. Include after adc.h.
+ */
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+// mV on each rail that reads full scale, AVCC (3.3 V, ADCSREF_0) times
+// the board's divider. V_BAT has 1/3 so a fresh 4 cell pack (6.4 V)
+// stays under full scale; the 5 V and 3.3 V rails have 1/2. V_3_3 is AVCC itself, so it reads 3300 mV whatever the supply
+// does, which checks the scale on the bench.
+#define BAT_DIV_NUM         (1)     // V_BAT divider, P5.0 A8
+#define BAT_DIV_DEN         (3)
+#define RAIL_DIV_NUM        (1)     // V_5_0 (P5.1 A9) and V_3_3 (P5.3 A11) dividers
+#define RAIL_DIV_DEN        (2)
+#define ADC_REF_MV          (3300)
+#define BAT_FULL_MV         (ADC_REF_MV * BAT_DIV_DEN / BAT_DIV_NUM)
+#define RAIL_5_0_FULL_MV    (ADC_REF_MV * RAIL_DIV_DEN / RAIL_DIV_NUM)
+#define RAIL_3_3_FULL_MV    (ADC_REF_MV * RAIL_DIV_DEN / RAIL_DIV_NUM)
+
+#define BAT_NOMINAL_MV      (6000)  // Duties are right at this voltage
+#define BAT_LOW_MV          (4800)  // Low battery below this
+#define BAT_OK_MV           (5000)  // and cleared above this
+
+// Duty compensation, BAT_NOMINAL_MV / V_BAT in 1/1024ths
+#define BAT_COMP_SHIFT      (10)
+#define BAT_COMP_ONE        (1 << BAT_COMP_SHIFT)
+#define BAT_COMP_MIN        (768)   // 0.75, fresh pack well above nominal
+#define BAT_COMP_MAX        (1536)  // 1.5, beyond this the pack is flat anyway
+#ifndef BAT_COMP_DEFAULT
+#define BAT_COMP_DEFAULT    (0)     // Off until ^0000V1
+#endif
+
+// rail_mv[] index, channel - ADC_VBAT
+#define RAIL_BAT            (0)
+#define RAIL_5_0            (1)
+#define RAIL_3_3            (2)
+
+extern unsigned int rail_mv[ADC_RAILS];
+extern char bat_low;
+extern unsigned int bat_comp;               // Multiplier used by motor_duty()
+
+void battery_compensation(char on);
+unsigned int motor_duty(unsigned int duty);
+
+#endif /* BATTERY_H_ */
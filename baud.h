@@ -0,0 +1,93 @@
+/*
+ * baud.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  eUSCI_A baud rate divisors worked out at compile time from SMCLK_FREQ,
+ *  following the "Baud-Rate Settings" procedure in the FR2xx user's guide:
+ *
+ *    N = SMCLK / baud
+ *    N >= 16 : UCOS16 = 1, UCBRx = INT(N / 16), UCBRFx = INT(N) % 16
+ *    N <  16 : UCOS16 = 0, UCBRx = INT(N)
+ *    UCBRSx  = table entry for the fractional part of N
+ */
+
+#ifndef BAUD_H_
+#define BAUD_H_
+
+// Index into baud_table, passed as the speed argument of Init_Serial_UCAx
+#define BAUD_9600       (0)
+#define BAUD_19200      (1)
+#define BAUD_38400      (2)
+#define BAUD_57600      (3)
+#define BAUD_115200     (4)
+#define BAUD_230400     (5)
+#define BAUD_460800     (6)
+#define BAUD_921600     (7)
+#define BAUD_COUNT      (8)
+
+#define BAUD_MAX_ERROR  (200)   // Largest average bit time error, 0.01% units
+#define BAUD_OS16_BIT   (0x0001)  // UCOS16 in UCAxMCTLW
+
+typedef struct {
+    unsigned long baud;
+    unsigned int brw;                   // UCAxBRW
+    unsigned int mctlw;                 // UCAxMCTLW = UCBRSx | UCBRFx | UCOS16
+    const char *at_command;             // Matching AT+UART_CUR for the ESP32
+} baud_setting;
+
+//------------------------------------------------------------------------------
+// N split into whole and fractional parts. The fraction is in 1/10000
+// steps, done in two parts so nothing overflows 32 bits.
+//------------------------------------------------------------------------------
+#define BAUD_N(baud)        (SMCLK_FREQ / (baud))
+#define BAUD_REM(baud)      (SMCLK_FREQ % (baud))
+#define BAUD_FRAC(baud)     (((BAUD_REM(baud) * 1000UL) / (baud)) * 10 + \
+                            (((BAUD_REM(baud) * 1000UL) % (baud)) * 10) / (baud))
+
+#define BAUD_OS16(baud)     (BAUD_N(baud) >= 16)
+#define BAUD_BR(baud)       (BAUD_OS16(baud) ? BAUD_N(baud) / 16 : BAUD_N(baud))
+#define BAUD_BRF(baud)      (BAUD_OS16(baud) ? BAUD_N(baud) % 16 : 0)
+
+//------------------------------------------------------------------------------
+// UCBRSx from the fractional part of N, user's guide table "UCBRSx
+// Settings for Fractional Portion of N". Takes the last entry that is
+// not larger than the fraction.
+//------------------------------------------------------------------------------
+#define UCBRS_LOOKUP(f) \
+    ((f) >= 9288 ? 0xFE : (f) >= 9170 ? 0xFD : (f) >= 9004 ? 0xFB : \
+     (f) >= 8751 ? 0xF7 : (f) >= 8572 ? 0xEF : (f) >= 8464 ? 0xDF : \
+     (f) >= 8333 ? 0xBF : (f) >= 8004 ? 0xEE : (f) >= 7861 ? 0xED : \
+     (f) >= 7503 ? 0xDD : (f) >= 7147 ? 0xBB : (f) >= 7001 ? 0xB7 : \
+     (f) >= 6667 ? 0xD6 : (f) >= 6432 ? 0xB6 : (f) >= 6254 ? 0xB5 : \
+     (f) >= 6003 ? 0xAD : (f) >= 5715 ? 0x6B : (f) >= 5002 ? 0xAA : \
+     (f) >= 4378 ? 0x55 : (f) >= 4286 ? 0x53 : (f) >= 4003 ? 0x92 : \
+     (f) >= 3753 ? 0x52 : (f) >= 3575 ? 0x4A : (f) >= 3335 ? 0x49 : \
+     (f) >= 3000 ? 0x25 : (f) >= 2503 ? 0x44 : (f) >= 2224 ? 0x22 : \
+     (f) >= 2147 ? 0x21 : (f) >= 1670 ? 0x11 : (f) >= 1430 ? 0x20 : \
+     (f) >= 1252 ? 0x10 : (f) >= 1001 ? 0x08 : (f) >= 835  ? 0x04 : \
+     (f) >= 715  ? 0x02 : (f) >= 529  ? 0x01 : 0x00)
+
+#define BAUD_BRS(baud)      UCBRS_LOOKUP(BAUD_FRAC(baud))
+#define BAUD_MCTLW(baud)    ((BAUD_BRS(baud) << 8) | (BAUD_BRF(baud) << 4) | \
+                            (BAUD_OS16(baud) ? BAUD_OS16_BIT : 0))
+
+//------------------------------------------------------------------------------
+// Average bit time error in 0.01% units. Each set UCBRSx bit stretches
+// one bit of the character by a clock, so over 8 bits the divisor is
+// INT(N) + ones(UCBRSx) / 8. Worked in eighths of a clock.
+//------------------------------------------------------------------------------
+#define BAUD_ONES(b)        (((b) & 1) + (((b) >> 1) & 1) + (((b) >> 2) & 1) + \
+                            (((b) >> 3) & 1) + (((b) >> 4) & 1) + (((b) >> 5) & 1) + \
+                            (((b) >> 6) & 1) + (((b) >> 7) & 1))
+#define BAUD_CLOCKS8(baud)  ((BAUD_N(baud) * 8 + BAUD_ONES(BAUD_BRS(baud))) * (baud))
+#define BAUD_DIFF8(baud)    (BAUD_CLOCKS8(baud) > SMCLK_FREQ * 8 ? \
+                            BAUD_CLOCKS8(baud) - SMCLK_FREQ * 8 : \
+                            SMCLK_FREQ * 8 - BAUD_CLOCKS8(baud))
+#define BAUD_ERROR(baud)    (BAUD_DIFF8(baud) / ((SMCLK_FREQ * 8) / 10000))
+
+#define BAUD_ENTRY(baud)    { baud##UL, BAUD_BR(baud), BAUD_MCTLW(baud), \
+                              "AT+UART_CUR=" #baud ",8,1,0,0\r\n" }
+
+#endif /* BAUD_H_ */
@@ -0,0 +1,201 @@
+/*
+ * bridge.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file contains the USB <-> IOT bridge. Instead of writing every
+ *  received byte straight into the other UART's TXBUF, the RX interrupt
+ *  hands it to bridge_rx which buffers it, and the other UART's TX
+ *  interrupt pulls it back out with bridge_next once TXBUF is free.
+ *  When a path's buffer is full the byte is dropped and counted rather
+ *  than overwriting TXBUF (neither UART has hardware flow control).
+ *
+ *  The USB to IOT path keeps '^' lines to itself: usb_commands runs
+ *  them, and the ESP32 would only answer ERROR, which iotlink.c takes
+ *  as the end of the reply it is sending. That path can also be held
+ *  by iotlink.c while AT+CIPSEND waits for its payload, so a typed
+ *  line never lands between the two. A line already half sent is
+ *  finished first.
+ *
+ *  Functions included:
+ *    - Init_Bridge: Clears both paths and selects full mirroring.
+ *    - bridge_set_mode: Selects off, full or filtered mirroring.
+ *    - bridge_keep_cmd: Swallows a '^' line and its line end.
+ *    - bridge_rx: RX ISR side, buffers a received byte for forwarding.
+ *    - bridge_next: TX ISR side, returns the next byte to forward.
+ *
+ */
+
+
+#include "msp430.h"
+#include "bridge.h"
+#include "macros.h"
+
+// '^' line states, keep_cmds paths only
+#define CMD_NONE        ('N')
+#define CMD_LINE        ('C')   // Inside a '^' line
+#define CMD_END         ('E')   // Its line end, '\r', '\n' or both
+
+bridge_path iot_to_usb;
+bridge_path usb_to_iot;
+volatile char bridge_mode;
+
+static void bridge_path_init(bridge_path *path);
+static char bridge_line_wanted(const bridge_path *path);
+static char bridge_keep_cmd(bridge_path *path, char c);
+
+void Init_Bridge(void){
+    bridge_path_init(&iot_to_usb);
+    bridge_path_init(&usb_to_iot);
+    usb_to_iot.keep_cmds = TRUE;
+    bridge_mode = MIRROR_FULL;
+}
+
+static void bridge_path_init(bridge_path *path){
+    ring_init(&path->ring, path->storage, sizeof(path->storage));
+    path->line_len = 0;
+    path->mid_line = FALSE;
+    path->keep_cmds = FALSE;
+    path->cmd_state = CMD_NONE;
+    path->hold = FALSE;
+    path->forwarded = 0;
+    path->dropped = 0;
+    path->overrun = 0;
+}
+
+//-----------------------------------------------------------------
+// Both RX interrupts work on line_len, so the switch is made with
+// interrupts off and no byte sees half of it.
+//-----------------------------------------------------------------
+void bridge_set_mode(char mode){
+    unsigned int state;
+
+    if(mode != MIRROR_OFF && mode != MIRROR_FULL && mode != MIRROR_FILTERED){
+        return;
+    }
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    iot_to_usb.line_len = 0;            // Partial lines belong to the old mode
+    usb_to_iot.line_len = 0;
+    bridge_mode = mode;
+    __set_interrupt_state(state);
+}
+
+//-----------------------------------------------------------------
+// A command line is one carrying a '^' command from Magic Smoke or
+// an AT command typed on the USB console.
+//-----------------------------------------------------------------
+static char bridge_line_wanted(const bridge_path *path){
+    unsigned int i;
+
+    if(path->line_len >= 2 && path->line[0] == 'A' && path->line[1] == 'T'){
+        return TRUE;
+    }
+    for(i = 0; i < path->line_len; i++){
+        if(path->line[i] == '^'){
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//-----------------------------------------------------------------
+// Returns TRUE when c belongs to a '^' line and is not forwarded. A
+// '^' throws away a partial line, as it does in iot_token.
+//-----------------------------------------------------------------
+static char bridge_keep_cmd(bridge_path *path, char c){
+    if(c == '^'){
+        path->cmd_state = CMD_LINE;
+        path->line_len = 0;
+        return TRUE;
+    }
+    switch(path->cmd_state){
+        case CMD_LINE:
+            if(c == '\r' || c == '\n'){
+                path->cmd_state = CMD_END;
+            }
+            return TRUE;
+        case CMD_END:
+            if(c == '\r' || c == '\n'){
+                return TRUE;
+            }
+            path->cmd_state = CMD_NONE;
+            return FALSE;
+        default:
+            return FALSE;
+    }
+}
+
+//-----------------------------------------------------------------
+// Called from the RX interrupt of the source UART.
+// Returns TRUE when something was added so the caller can enable the
+// TX interrupt of the other UART.
+// In filtered mode a line is held back until its '\r' or '\n' and
+// then forwarded whole, or not at all.
+//-----------------------------------------------------------------
+char bridge_rx(bridge_path *path, char c){
+    if(path->keep_cmds && bridge_keep_cmd(path, c)){
+        return FALSE;
+    }
+    switch(bridge_mode){
+        case MIRROR_FULL:
+            if(!ring_put(&path->ring, c)){
+                path->dropped++;
+                return FALSE;
+            }
+            return TRUE;
+
+        case MIRROR_FILTERED:
+            if(c != '\r' && c != '\n'){
+                if(path->line_len < sizeof(path->line)){
+                    path->line[path->line_len] = c;
+                }
+                path->line_len++;               // Keeps counting past the end
+                return FALSE;
+            }
+            if(path->line_len == 0){
+                return FALSE;
+            }
+            if(path->line_len > sizeof(path->line)){
+                path->dropped += path->line_len;    // Too long to hold
+                path->line_len = 0;
+                return FALSE;
+            }
+            if(!bridge_line_wanted(path)){
+                path->line_len = 0;
+                return FALSE;
+            }
+            if(ring_space(&path->ring) < path->line_len + 2){
+                path->dropped += path->line_len;
+                path->line_len = 0;
+                return FALSE;
+            }
+            ring_write(&path->ring, path->line, path->line_len);
+            ring_write(&path->ring, "\r\n", 2);
+            path->line_len = 0;
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+//-----------------------------------------------------------------
+// Called from the TX interrupt of the destination UART when TXBUF is
+// empty. Returns FALSE when there is nothing waiting, or when the
+// path is held and the last line has been finished.
+//-----------------------------------------------------------------
+char bridge_next(bridge_path *path, char *c){
+    if(path->hold && !path->mid_line){
+        return FALSE;
+    }
+    if(!ring_get(&path->ring, c)){
+        return FALSE;
+    }
+    path->mid_line = (*c != '\n');
+    path->forwarded++;
+    return TRUE;
+}
@@ -0,0 +1,50 @@
+/*
+ * bridge.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  USB <-> IOT mirror. Bytes received on one UART are buffered here and
+ *  sent out of the other UART from its TX interrupt. '^' command lines
+ *  typed on the USB port are run by usb_commands and stay out of the
+ *  ESP32's way, and forwarding to it pauses while a reply is being
+ *  sent with AT+CIPSEND.
+ */
+
+#ifndef BRIDGE_H_
+#define BRIDGE_H_
+
+#include "ringbuf.h"
+
+#define BRIDGE_RING_SIZE (128)  // Must be a power of two
+#define BRIDGE_LINE_SIZE (48)   // Longest line held back in filtered mode
+
+// Mirror modes
+#define MIRROR_OFF      ('0')   // Nothing is forwarded
+#define MIRROR_FULL     ('1')   // Every byte is forwarded
+#define MIRROR_FILTERED ('2')   // Only command lines are forwarded
+
+typedef struct {
+    ring_buf ring;                      // Waiting for the other TX interrupt
+    char storage[BRIDGE_RING_SIZE];
+    char line[BRIDGE_LINE_SIZE];        // Line being collected, filtered mode
+    unsigned int line_len;
+    char mid_line;                      // TX side, last byte sent was not '\n'
+    char keep_cmds;                     // '^' lines are not forwarded
+    char cmd_state;                     // Where in a '^' line, keep_cmds paths
+    volatile char hold;                 // Forward nothing new until cleared
+    volatile unsigned int forwarded;    // Bytes handed to the other UART
+    volatile unsigned int dropped;      // Bytes lost because the ring was full
+    volatile unsigned int overrun;      // Receive overruns on the source UART
+} bridge_path;
+
+extern bridge_path iot_to_usb;
+extern bridge_path usb_to_iot;
+extern volatile char bridge_mode;
+
+void Init_Bridge(void);
+void bridge_set_mode(char mode);
+char bridge_rx(bridge_path *path, char c);
+char bridge_next(bridge_path *path, char *c);
+
+#endif /* BRIDGE_H_ */
@@ -0,0 +1,234 @@
+/*
+ * calibrate.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file calibrates the two line detectors. SW1 (or ^0000Z) starts
+ *  it and SW1 steps through it: hold the car over white and press,
+ *  wait for the samples, hold it over black and press again. Nothing
+ *  else takes SW1 presses, so Calibration_Process watches for them
+ *  even while idle. Each surface is sampled for CAL_SAMPLE_MS from the
+ *  ADC snapshot, keeping the mean and the peak to peak noise per
+ *  detector.
+ *
+ *  The threshold pair sits around the middle of white and black, half
+ *  the worst noise plus a margin either side, so a detector has to go
+ *  past high to count as on the line and back under low to leave it.
+ *  The result goes to FRAM with a CRC. At boot a good record is used,
+ *  otherwise both thresholds are LINE_THRESHOLD as before. A run where
+ *  black is not clearly above white is thrown away.
+ *
+ *  Functions included:
+ *    - Init_Calibration: Loads the stored calibration or the defaults.
+ *    - Calibration: SW1 for the calibration, starts or steps it.
+ *    - Calibration_Process: Takes SW1, collects samples and finishes each step.
+ *    - cal_show: Puts a calibration prompt on the display.
+ *    - cal_finish: Makes the thresholds and stores them.
+ *    - cal_black: Hysteresis test of one detector reading.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "telemetry.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "adc.h"
+#include "calibrate.h"
+
+extern char display_line[4][11];
+extern volatile unsigned char display_changed;
+extern volatile unsigned int sw1_position;
+
+typedef struct {
+    unsigned long sum;
+    unsigned int count;
+    unsigned int min;
+    unsigned int max;
+} cal_stats;
+
+// In FRAM, survives a reset and a power cycle. Only the loader sets it.
+#pragma PERSISTENT(cal_store)
+cal_record cal_store = { 0 };
+
+cal_sensor cal_active[ADC_DETECTORS];
+cal_sensor cal_new[ADC_DETECTORS];
+cal_stats cal_sampling[ADC_DETECTORS];
+unsigned char cal_step;
+unsigned long cal_last_stamp;           // Snapshot already counted
+sw_timer cal_timer;
+
+void cal_finish(void);
+
+void Init_Calibration(void){
+    unsigned char i;
+
+    cal_step = CAL_IDLE;
+    if(cal_store.magic == CAL_MAGIC &&
+       crc16((const unsigned char *)&cal_store, sizeof(cal_store) - sizeof(cal_store.crc),
+             TLM_CRC_START) == cal_store.crc){
+        memcpy(cal_active, cal_store.sensor, sizeof(cal_active));
+        return;
+    }
+    memset(cal_active, 0, sizeof(cal_active));
+    for(i = 0; i < ADC_DETECTORS; i++){
+        cal_active[i].low = LINE_THRESHOLD;
+        cal_active[i].high = LINE_THRESHOLD;
+    }
+}
+
+static void cal_show(const char *line1, const char *line2){
+    strcpy(display_line[0], line1);
+    strcpy(display_line[1], line2);
+    display_changed = TRUE;
+}
+
+//-----------------------------------------------------------------
+// SW1 while calibrating. Presses during sampling are ignored.
+//-----------------------------------------------------------------
+void Calibration(void){
+    switch(cal_step){
+        case CAL_IDLE:
+            sw1_position = 0;           // Only presses from now on count
+            cal_step = CAL_WHITE_WAIT;
+            cal_show(" CAL WHITE", " SW1 = GO ");
+            break;
+        case CAL_WHITE_WAIT:
+        case CAL_BLACK_WAIT:
+            memset(cal_sampling, 0, sizeof(cal_sampling));
+            cal_sampling[ADC_LEFT].min = 0xFFFF;
+            cal_sampling[ADC_RIGHT].min = 0xFFFF;
+            cal_last_stamp = 0;
+            swt_start(&cal_timer, MS_TO_TICKS(CAL_SAMPLE_MS), SWT_ONE_SHOT);
+            cal_step++;                 // CAL_WHITE or CAL_BLACK
+            cal_show(" SAMPLING ", "          ");
+            break;
+        default:
+            break;
+    }
+}
+
+void Calibration_Process(void){
+    adc_snapshot snap;
+    cal_stats *stats;
+    unsigned int value;
+    unsigned char i;
+
+    switch(cal_step){
+        case CAL_IDLE:                  // SW1 starts it
+        case CAL_WHITE_WAIT:
+        case CAL_BLACK_WAIT:
+            if(sw1_position){
+                sw1_position = 0;
+                Calibration();
+            }
+            return;
+        case CAL_WHITE:
+        case CAL_BLACK:
+            break;
+        default:
+            return;
+    }
+
+    adc_read(&snap);
+    if(snap.stamp[ADC_LEFT] != cal_last_stamp){
+        cal_last_stamp = snap.stamp[ADC_LEFT];
+        for(i = 0; i < ADC_DETECTORS; i++){
+            stats = &cal_sampling[i];
+            value = snap.value[i];
+            stats->sum += value;
+            stats->count++;
+            if(value < stats->min){
+                stats->min = value;
+            }
+            if(value > stats->max){
+                stats->max = value;
+            }
+        }
+    }
+    if(!swt_fired(&cal_timer)){
+        return;
+    }
+
+    for(i = 0; i < ADC_DETECTORS; i++){
+        stats = &cal_sampling[i];
+        value = stats->count ? stats->sum / stats->count : 0;
+        if(cal_step == CAL_WHITE){
+            cal_new[i].white = value;
+            cal_new[i].white_noise = stats->count ? stats->max - stats->min : 0;
+        } else {
+            cal_new[i].black = value;
+            cal_new[i].black_noise = stats->count ? stats->max - stats->min : 0;
+        }
+    }
+    if(cal_step == CAL_WHITE){
+        cal_step = CAL_BLACK_WAIT;
+        cal_show(" CAL BLACK", " SW1 = GO ");
+    } else {
+        cal_finish();
+        cal_step = CAL_IDLE;
+    }
+}
+
+//-----------------------------------------------------------------
+// The band between low and high never takes more than half of the
+// gap between white and black.
+//-----------------------------------------------------------------
+void cal_finish(void){
+    cal_record record;
+    cal_sensor *sensor;
+    unsigned int span;
+    unsigned int mid;
+    unsigned int half;
+    unsigned int state;
+    unsigned char i;
+
+    for(i = 0; i < ADC_DETECTORS; i++){
+        sensor = &cal_new[i];
+        if(sensor->black < sensor->white + CAL_MIN_SPAN){
+            cal_show(" CAL FAIL ", "          ");    // Old calibration stays
+            return;
+        }
+        span = sensor->black - sensor->white;
+        mid = sensor->white + span / 2;
+        half = (sensor->white_noise > sensor->black_noise ?
+                sensor->white_noise : sensor->black_noise) / 2 + CAL_HYST_MARGIN;
+        if(half > span / 4){
+            half = span / 4;
+        }
+        sensor->low = mid - half;
+        sensor->high = mid + half;
+    }
+
+    record.magic = CAL_MAGIC;
+    memcpy(record.sensor, cal_new, sizeof(record.sensor));
+    record.crc = crc16((const unsigned char *)&record, sizeof(record) - sizeof(record.crc),
+                       TLM_CRC_START);
+
+    SYSCFG0 = FRWPPW | DFWP;            // Program FRAM writable for cal_store
+    cal_store = record;
+    SYSCFG0 = FRWPPW | DFWP | PFWP;
+
+    state = __get_interrupt_state();
+    __disable_interrupt();              // ADC_ISR reads cal_active in edge_window
+    memcpy(cal_active, cal_new, sizeof(cal_active));
+    __set_interrupt_state(state);
+    cal_show(" CAL DONE ", "          ");
+}
+
+//-----------------------------------------------------------------
+// TRUE if the detector is over black. was_black is the last answer
+// for the same detector, the threshold it has to cross depends on it.
+//-----------------------------------------------------------------
+char cal_black(unsigned char sensor, unsigned int value, char was_black){
+    if(was_black){
+        return value > cal_active[sensor].low;
+    }
+    return value > cal_active[sensor].high;
+}
@@ -0,0 +1,50 @@
+/*
+ * calibrate.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Line detector calibration. White and black statistics and the
+ *  hysteresis thresholds made from them are kept in FRAM with a CRC
+ *  and loaded at boot. Values are adc_snapshot units (ADC_SNAP_BITS).
+ *  Include after adc.h.
+ */
+
+#ifndef CALIBRATE_H_
+#define CALIBRATE_H_
+
+#define CAL_MAGIC           (0xCA11)
+#define CAL_SAMPLE_MS       (1500)  // Time each surface is sampled for
+#define CAL_MIN_SPAN        ADC_FROM_10BIT(100)     // Black must read this far above white
+#define CAL_HYST_MARGIN     ADC_FROM_10BIT(8)       // Added to half the noise
+
+// Calibration steps
+#define CAL_IDLE            (0)
+#define CAL_WHITE_WAIT      (1)     // Waiting for SW1 over white
+#define CAL_WHITE           (2)
+#define CAL_BLACK_WAIT      (3)     // Waiting for SW1 over black
+#define CAL_BLACK           (4)
+
+typedef struct {
+    unsigned int white;             // Mean over white
+    unsigned int black;             // Mean over black
+    unsigned int white_noise;       // Peak to peak over white
+    unsigned int black_noise;
+    unsigned int low;               // Below this the detector has left the line
+    unsigned int high;              // Above this the detector is on the line
+} cal_sensor;
+
+typedef struct {
+    unsigned int magic;
+    cal_sensor sensor[ADC_DETECTORS];
+    unsigned int crc;               // crc16 of everything before it
+} cal_record;
+
+extern cal_sensor cal_active[ADC_DETECTORS];
+extern unsigned char cal_step;
+
+void Init_Calibration(void);
+void Calibration_Process(void);
+char cal_black(unsigned char sensor, unsigned int value, char was_black);
+
+#endif /* CALIBRATE_H_ */
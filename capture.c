@@ -0,0 +1,211 @@
+/*
+ * capture.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file records the raw detector waveform for tuning thresholds.
+ *  ^0000G arms it (see CAP_CMD_... in capture.h). ADC_ISR hands every
+ *  conversion to capture_sample, and each completed detector pair is
+ *  stored as one record with the latest thumbwheel conversion, the
+ *  emitter state and the number of ADC slots since the record before.
+ *  The slots are timed by TB1, so the host can rebuild the times from
+ *  the slot count alone.
+ *
+ *  While armed the ring is overwritten continuously. The trigger is
+ *  ^0000G2, or either detector going through a level with the emitter
+ *  on. The CAP_PRETRIGGER records before it are kept and the rest of
+ *  the ring is filled after it. Then the ADC goes back to ADC_SLOT_US
+ *  and capture_process sends the block a few records per frame as the
+ *  telemetry buffers come free. The filters, snapshot and line follower
+ *  keep running on the same conversions the whole time, so a capture
+ *  can be taken during a real run.
+ *
+ *  Functions included:
+ *    - capture_sample: ISR side, pairs conversions into records.
+ *    - capture_command: Arms, triggers or stops a capture.
+ *    - capture_process: Sends the next frame of a finished capture.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "adc.h"
+#include "capture.h"
+
+cap_record cap_ring[CAP_DEPTH];
+volatile unsigned char cap_state;
+unsigned char cap_command;              // CAP_CMD_... that armed it
+volatile unsigned char cap_fire;        // Trigger seen: detector + 1 or CAP_SOURCE_MANUAL
+unsigned int cap_level;                 // Crossing level, raw 12 bit
+unsigned int cap_prev[ADC_DETECTORS];   // Last emitter-on conversion, for crossings
+unsigned int cap_left;                  // Left conversion waiting for its pair
+unsigned int cap_thumb;
+unsigned char cap_slots;                // Slots since the last record
+unsigned int cap_head;                  // Next record to write
+unsigned int cap_filled;                // Records written since arming, up to CAP_DEPTH
+unsigned int cap_start;                 // First record of the capture
+unsigned int cap_pre;                   // Records before the trigger
+unsigned int cap_post;                  // Records still to write after the trigger
+unsigned int cap_sent;                  // Records sent so far
+unsigned char cap_id;                   // Counts captures, sent in every frame
+unsigned char cap_source;               // Detector that crossed or CAP_SOURCE_MANUAL
+unsigned long cap_trigger_us;
+
+//-----------------------------------------------------------------
+// Called from ADC_ISR for every conversion, after the next slot
+// has been set up. Only the emitter-on conversions of a
+// detector are tested for a crossing, in ADC_IR_SYNC the off ones
+// would trip it on every pair.
+//-----------------------------------------------------------------
+void capture_sample(unsigned char channel, unsigned int result, unsigned char off){
+  cap_record *record;
+
+  if(cap_state != CAP_ARMED && cap_state != CAP_TRIGGERED){
+    return;
+  }
+  if(cap_slots < CAP_SLOTS_MAX){
+    cap_slots++;
+  }
+  if(channel == ADC_THUMB){
+    cap_thumb = result;
+    return;
+  }
+  if(channel == ADC_LEFT){
+    cap_left = result;
+  }
+  if(channel >= ADC_DETECTORS){
+    return;
+  }
+
+  if(cap_state == CAP_ARMED && !off && !cap_fire && cap_prev[channel] != 0xFFFF){
+    if(cap_command == CAP_CMD_RISE && cap_prev[channel] < cap_level && result >= cap_level){
+      cap_fire = channel + 1;
+    } else if(cap_command == CAP_CMD_FALL && cap_prev[channel] >= cap_level && result < cap_level){
+      cap_fire = channel + 1;
+    }
+  }
+  if(!off){
+    cap_prev[channel] = result;
+  }
+  if(channel != ADC_RIGHT){
+    return;
+  }
+
+  if(cap_state == CAP_ARMED && cap_fire){
+    cap_source = cap_fire == CAP_SOURCE_MANUAL ? CAP_SOURCE_MANUAL : cap_fire - 1;
+    cap_fire = 0;
+    cap_pre = cap_filled < CAP_PRETRIGGER ? cap_filled : CAP_PRETRIGGER;
+    cap_start = (cap_head - cap_pre) & CAP_MASK;
+    cap_post = CAP_DEPTH - CAP_PRETRIGGER;  // The trigger record is the first of these
+    cap_trigger_us = now_us();
+    cap_state = CAP_TRIGGERED;
+  }
+
+  record = &cap_ring[cap_head];
+  record->left = (cap_left & CAP_RAW) | ((unsigned int)cap_slots << CAP_SLOTS_SHIFT);
+  record->right = (result & CAP_RAW) | (off ? CAP_LED_OFF : 0);
+  record->thumb = cap_thumb;
+  cap_slots = 0;
+  cap_head = (cap_head + 1) & CAP_MASK;
+  if(cap_filled < CAP_DEPTH){
+    cap_filled++;
+  }
+
+  if(cap_state == CAP_TRIGGERED && !--cap_post){
+    adc_set_slot(ADC_SLOT_US);
+    cap_sent = 0;
+    cap_state = CAP_SENDING;
+  }
+}
+
+void capture_command(unsigned char command, unsigned int level){
+  switch(command){
+    case CAP_CMD_STOP:
+      cap_state = CAP_OFF;
+      adc_set_slot(ADC_SLOT_US);
+      break;
+
+    case CAP_CMD_FIRE:
+      if(cap_state == CAP_ARMED){
+        cap_fire = CAP_SOURCE_MANUAL;   // Taken up with the next record
+      }
+      break;
+
+    case CAP_CMD_ARM:
+    case CAP_CMD_RISE:
+    case CAP_CMD_FALL:
+      if(cap_state == CAP_TRIGGERED || cap_state == CAP_SENDING){
+        break;                          // Finish the one in hand first
+      }
+      cap_state = CAP_OFF;              // The ISR leaves it alone while set up
+      cap_command = command;
+      cap_level = level << 2;           // 10 bit to raw 12 bit
+      cap_fire = 0;
+      cap_prev[ADC_LEFT] = 0xFFFF;
+      cap_prev[ADC_RIGHT] = 0xFFFF;
+      cap_left = 0;
+      cap_thumb = 0;
+      cap_slots = 0;
+      cap_head = 0;
+      cap_filled = 0;
+      cap_id++;
+      adc_set_slot(CAP_SLOT_US);
+      cap_state = CAP_ARMED;
+      break;
+
+    default:
+      break;
+  }
+}
+
+//-----------------------------------------------------------------
+// Main loop side, from Telemetry_Process. One frame per call, and
+// only when a telemetry buffer is free, so a dump never holds up
+// the loop; the status frames just get skipped more while it runs.
+//-----------------------------------------------------------------
+void capture_process(void){
+  unsigned char payload[TLM_MAX_PAYLOAD];
+  cap_record *record;
+  unsigned int total;
+  unsigned int count;
+  unsigned int i;
+
+  if(cap_state != CAP_SENDING || !telemetry_ready()){
+    return;
+  }
+  total = cap_pre + CAP_DEPTH - CAP_PRETRIGGER;
+  count = total - cap_sent;
+  if(count > TLM_CAP_PER_FRAME){
+    count = TLM_CAP_PER_FRAME;
+  }
+
+  payload[TLM_CAP_ID] = cap_id;
+  payload[TLM_CAP_SOURCE] = cap_source;
+  put_u16(&payload[TLM_CAP_FIRST], cap_sent);
+  put_u16(&payload[TLM_CAP_TOTAL], total);
+  put_u16(&payload[TLM_CAP_PRE], cap_pre);
+  put_u16(&payload[TLM_CAP_SLOT_US], CAP_SLOT_US);
+  put_u16(&payload[TLM_CAP_LEVEL], cap_command == CAP_CMD_ARM ? 0 : cap_level);
+  put_u32(&payload[TLM_CAP_TRIG_US], cap_trigger_us);
+  for(i = 0; i < count; i++){
+    record = &cap_ring[(cap_start + cap_sent + i) & CAP_MASK];
+    put_u16(&payload[TLM_CAP_RECORDS + i * TLM_CAP_REC_LEN + TLM_CR_LEFT], record->left);
+    put_u16(&payload[TLM_CAP_RECORDS + i * TLM_CAP_REC_LEN + TLM_CR_RIGHT], record->right);
+    put_u16(&payload[TLM_CAP_RECORDS + i * TLM_CAP_REC_LEN + TLM_CR_THUMB], record->thumb);
+  }
+  if(!telemetry_send(TLM_TYPE_CAPTURE, payload, TLM_CAP_RECORDS + count * TLM_CAP_REC_LEN)){
+    return;
+  }
+  cap_sent += count;
+  if(cap_sent >= total){
+    cap_state = CAP_OFF;
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * capture.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Raw ADC capture. While armed every detector pair is written to a
+ *  RAM ring of CAP_DEPTH records with the ADC slots sped up to
+ *  CAP_SLOT_US. A trigger keeps CAP_PRETRIGGER records from before it,
+ *  fills the rest of the ring and sends the block as capture telemetry
+ *  frames. Include after adc.h.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#ifndef CAP_DEPTH
+#define CAP_DEPTH           (128)   // Records, 6 bytes each
+#endif
+#define CAP_MASK            (CAP_DEPTH - 1)
+#ifndef CAP_PRETRIGGER
+#define CAP_PRETRIGGER      (CAP_DEPTH / 4)     // Records kept from before the trigger
+#endif
+#ifndef CAP_SLOT_US
+#define CAP_SLOT_US         (125)   // ADC slot while capturing, see adc_missed if lost
+#endif
+
+#if CAP_DEPTH & CAP_MASK
+#error "CAP_DEPTH must be a power of two"
+#endif
+#if CAP_PRETRIGGER >= CAP_DEPTH
+#error "CAP_PRETRIGGER must be less than CAP_DEPTH"
+#endif
+#if CAP_SLOT_US < 100 || CAP_SLOT_US > ADC_SLOT_US
+#error "CAP_SLOT_US must be 100 to ADC_SLOT_US"
+#endif
+
+// cap_state
+#define CAP_OFF             (0)
+#define CAP_ARMED           (1)     // Filling the ring, waiting for the trigger
+#define CAP_TRIGGERED       (2)     // Filling the records after the trigger
+#define CAP_SENDING         (3)     // Ring frozen, frames going out
+
+// ^0000G<command>[,<level>]
+#define CAP_CMD_STOP        (0)     // Disarm, or abandon a dump
+#define CAP_CMD_ARM         (1)     // Arm for a manual trigger
+#define CAP_CMD_FIRE        (2)     // Manual trigger
+#define CAP_CMD_RISE        (3)     // Arm, either detector rising through level
+#define CAP_CMD_FALL        (4)     // Arm, either detector falling through level
+#define CAP_CMD_COUNT       (5)
+#define CAP_LEVEL_MAX       (1023)  // level is in 10 bit units, like the display
+#define CAP_LEVEL_DEFAULT   (LINE_THRESHOLD >> (ADC_SNAP_BITS - 10))
+#define CAP_SOURCE_MANUAL   (0xFF)  // Trigger source in the frames, else ADC_LEFT or ADC_RIGHT
+
+// Record fields, a raw 12 bit conversion in each
+#define CAP_RAW             (0x0FFF)
+#define CAP_SLOTS_SHIFT     (12)    // left: slots since the previous record
+#define CAP_SLOTS_MAX       (15)
+#define CAP_LED_OFF         (0x8000)    // right: emitter was off for the pair
+
+typedef struct {
+    unsigned int left;
+    unsigned int right;
+    unsigned int thumb;             // Latest thumbwheel conversion
+} cap_record;
+
+extern volatile unsigned char cap_state;
+
+void capture_sample(unsigned char channel, unsigned int result, unsigned char off);
+void capture_command(unsigned char command, unsigned int level);
+void capture_process(void);
+
+#endif /* CAPTURE_H_ */
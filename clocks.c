@@ -28,7 +28,6 @@
 #include "macros.h"
 
 // MACROS========================================================================
-#define MCLK_FREQ_MHZ           (8) // MCLK = 8MHz
 #define CLEAR_REGISTER     (0X0000)
 
 void Init_Clocks(void);
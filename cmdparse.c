@@ -0,0 +1,115 @@
+/*
+ * cmdparse.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file checks the key on an IOT command, looks its opcode up in
+ *  the dispatch table and reads the decimal arguments the table entry
+ *  asks for. The lookup is a single array index, and new commands are
+ *  added as table entries without touching the parser. Nothing here
+ *  uses the MSP430 registers, so it builds and runs on a PC as well.
+ *
+ *  Functions included:
+ *    - cmd_number: Reads one decimal argument.
+ *    - cmd_parse: Splits a command into opcode and arguments.
+ *
+ */
+
+
+#include "macros.h"
+#include "cmdparse.h"
+
+//-----------------------------------------------------------------
+// Reads up to CMD_MAX_DIGITS digits at *text, moving *text past them.
+// Returns CMD_BAD_ARG when there are no digits or too many.
+//-----------------------------------------------------------------
+static char cmd_number(const char **text, unsigned long *value){
+    const char *p = *text;
+    char digits = 0;
+
+    *value = 0;
+    while(*p >= '0' && *p <= '9'){
+        if(++digits > CMD_MAX_DIGITS){
+            return CMD_BAD_ARG;
+        }
+        *value = *value * 10 + (*p++ - '0');
+    }
+    if(!digits){
+        return CMD_BAD_ARG;
+    }
+    *text = p;
+    return CMD_OK;
+}
+
+//-----------------------------------------------------------------
+// Fills args from command and returns CMD_OK, or the reason the
+// command was refused. args->text is set whenever the key matched.
+//-----------------------------------------------------------------
+char cmd_parse(const char *command, const char *key,
+               const cmd_entry *table, cmd_args *args){
+    const cmd_entry *entry;
+    const char *p = command;
+    unsigned long value;
+    char negative = FALSE;
+
+    while(*key){
+        if(*p++ != *key++){
+            return CMD_BAD_KEY;
+        }
+    }
+    args->text = p;
+    args->replace = FALSE;
+    args->count = 0;
+    args->arg[0] = 0;
+    args->arg[1] = 0;
+
+    if(*p == '!'){
+        args->replace = TRUE;
+        p++;
+    }
+    args->opcode = *p++;
+    if(args->opcode < CMD_FIRST || args->opcode > CMD_LAST){
+        return CMD_UNKNOWN;
+    }
+    entry = &table[CMD_INDEX(args->opcode)];
+    if(!entry->handler){
+        return CMD_UNKNOWN;
+    }
+
+    if(entry->flags & CMD_ARG_NUM){
+        if(*p == '-' && (entry->flags & CMD_ARG_SIGNED)){
+            negative = TRUE;
+            p++;
+        }
+        if(cmd_number(&p, &value) != CMD_OK){
+            return CMD_BAD_ARG;
+        }
+        if(value > entry->max){
+            return CMD_RANGE;
+        }
+        if(entry->scale){
+            value *= entry->scale;
+        }
+        args->arg[0] = negative ? -(int)value : (int)value;
+        args->count = 1;
+
+        if(*p == ',' && (entry->flags & CMD_ARG_OPT2)){
+            p++;
+            if(cmd_number(&p, &value) != CMD_OK){
+                return CMD_BAD_ARG;
+            }
+            if(value > entry->max2){
+                return CMD_RANGE;
+            }
+            args->arg[1] = (int)value;
+            args->count = 2;
+        }
+    }
+    if(*p){
+        return CMD_BAD_ARG;
+    }
+    return CMD_OK;
+}
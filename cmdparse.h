@@ -0,0 +1,69 @@
+/*
+ * cmdparse.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Parser for the '^' commands from the IOT link. A command is
+ *
+ *    <key> [!] <opcode> [-] <digits> [, <digits>]
+ *
+ *  The opcode picks an entry from a const table indexed by the opcode
+ *  character, and the entry says which arguments it takes, how the
+ *  first one is scaled and what handler runs it. Only depends on the
+ *  standard C types so the parser also builds on the host.
+ */
+
+#ifndef CMDPARSE_H_
+#define CMDPARSE_H_
+
+//------------------------------------------------------------------------------
+// Table covers the printable opcodes ' ' to '_', so upper case letters and
+// punctuation. cmd_table[CMD_INDEX(op)] is the entry for op.
+//------------------------------------------------------------------------------
+#define CMD_FIRST           (' ')
+#define CMD_LAST            ('_')
+#define CMD_TABLE_SIZE      (CMD_LAST - CMD_FIRST + 1)
+#define CMD_INDEX(op)       ((op) - CMD_FIRST)
+#define CMD_MAX_ARGS        (2)
+#define CMD_MAX_DIGITS      (5)
+
+// Argument schema flags
+#define CMD_ARG_NONE        (0x00)
+#define CMD_ARG_NUM         (0x01)  // First argument is required
+#define CMD_ARG_SIGNED      (0x02)  // First argument may start with '-'
+#define CMD_ARG_OPT2        (0x04)  // Optional ",n" second argument
+#define CMD_SHOW            (0x08)  // Echo the command on the display
+#define CMD_ANY_LINK        (0x10)  // Allowed from links other than the controller
+#define CMD_MOVE            (0x20)  // Applied later by movement_machine
+#define CMD_DARK            (0x40)  // Turns the LCD backlight off
+
+// cmd_parse results
+#define CMD_OK              (0)
+#define CMD_BAD_KEY         (1)     // Key missing or wrong
+#define CMD_UNKNOWN         (2)     // No table entry for the opcode
+#define CMD_BAD_ARG         (3)     // Missing digits or stray characters
+#define CMD_RANGE           (4)     // Argument larger than the entry allows
+
+typedef struct {
+    char opcode;
+    unsigned char link;             // Link the command came in on
+    unsigned char stamp;            // Latency record, filled in by the caller
+    char replace;                   // Command started with '!'
+    char count;                     // Arguments given
+    int arg[CMD_MAX_ARGS];          // arg[0] already scaled
+    const char *text;               // Command text after the key
+} cmd_args;
+
+typedef struct {
+    void (*handler)(const cmd_args *args);
+    unsigned char flags;
+    unsigned char scale;            // arg[0] is multiplied by this, 0 = 1
+    unsigned int max;               // Largest arg[0] before scaling
+    unsigned int max2;              // Largest arg[1]
+} cmd_entry;
+
+char cmd_parse(const char *command, const char *key,
+               const cmd_entry *table, cmd_args *args);
+
+#endif /* CMDPARSE_H_ */
@@ -6,15 +6,18 @@
  *
  *  Description:
  *  ------------
- *  This file contains the logic for handling IOT boot commands, parsing
- *  incoming IOT data, and executing movement commands. It processes SSID
- *  and IP information from the IOT module and interprets special command
+ *  This file contains the logic for parsing incoming IOT data and
+ *  executing movement commands. It interprets special command
  *  sequences to control the robot’s movement and display output.
  *
  *  Functions included:
- *    - bootIOT: Manages the IOT boot process and extracts SSID and IP info.
- *    - iot_commands: Parses incoming IOT commands and sets system actions.
- *    - movement_machine: Executes robot movement based on the current command.
+ *    - iot_commands: Reads +IPD payloads and sends queued replies.
+ *    - iot_payload: Runs one slice of a payload through the tokenizer.
+ *    - usb_commands: Runs the '^' commands typed on the USB port.
+ *    - iot_token: Collects a link's '^' commands one byte at a time.
+ *    - cmd_move ... cmd_exit: Handlers named in cmd_table.
+ *    - iot_dispatch: Parses one complete command and runs its handler.
+ *    - motion_add: Appends a move, or replaces the queue with it.
  *
  */
 
@@ -25,306 +28,339 @@
 #include "LCD.h"
 #include "ports.h"
 #include "macros.h"
+#include "ringbuf.h"
+#include "bridge.h"
+#include "motion.h"
+#include "cmdparse.h"
+#include "baud.h"
+#include "iotlink.h"
+#include "latency.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "isrprof.h"
+#include "adc.h"
+#include "battery.h"
+#include "capture.h"
+#include "edge.h"
+#include "swtimer.h"
 
 extern volatile unsigned char display_changed;
 extern char display_line[4][11];
 
-extern unsigned int iot_tx;
-extern unsigned int iot_rx;
-extern char iot_rx_buf [160];
-extern char iot_tx_buf [160];
-extern unsigned int usb_tx;
-extern unsigned int usb_rx;
-extern char usb_rx_buf [160];
-extern char usb_tx_buf [160];
+extern ring_buf iot_rx_ring;
+extern ring_buf usb_rx_ring;
 extern char process_buf [4][40];
 extern unsigned int process_buf_ptr1;
 extern unsigned int process_buf_ptr2;
-extern unsigned int read_ptr;
 extern unsigned int cmdFram;
 
-char iotState;
-unsigned int startSSID;
-char ssidName [20];
-unsigned int checkInput;
-unsigned int ssid_ptr;
-extern unsigned int iot_boot_timer;
-unsigned int startIP;
-char ipName[20];
-unsigned int ip_ptr;
-
-char iotCmd[3][15];
-unsigned int bigCmd_ptr;
-unsigned int smCmd_ptr;
-unsigned int startCaret;
-unsigned int time;
-
-char movement;
-unsigned int timeLength;
+unsigned int cmd_overflow;
+unsigned int cmd_rejected;              // Bad key, opcode or arguments
+
+extern char movement;
 
 unsigned int startMove;
 
 unsigned int padNum;
 
-unsigned int timer_start;
-volatile unsigned int wait;
+extern unsigned long bl_move_start;
 
 extern char BLState;
 
+extern unsigned long telemetry_period;
+
+
+//-----------------------------------------------------------------
+// Command logic sent from Magic Smoke
+// Everything waiting in iot_rx_ring is split into +IPD payloads in
+// one call, so a whole payload (possibly holding several commands)
+// is acted on in the same pass through the main loop it arrived in.
+// Queued replies are then passed on to the module.
+//-----------------------------------------------------------------
 
-void bootIOT(void){
-    if(iot_boot_timer >= 1500){
-        iot_commands();
-        timer_start = 1;
-        P2OUT |= IR_LED;
-    } else if(iotState == WAITIP && iot_boot_timer >= 1100){
-        strcpy(iot_tx_buf,"AT+CIFSR\r\n");
-        UCA0IE |= UCTXIE;
-        iotState = IP;
-    } else if(iotState == WAITSSID && iot_boot_timer >= 900){
-        strcpy(iot_tx_buf, "AT+CWJAP?\r\n");
-        UCA0IE |= UCTXIE;
-        iotState = SSID;
-    } else if(iotState == SERVER && iot_boot_timer >= 700){
-        strcpy(iot_tx_buf, "AT+CIPSERVER=1,22222\r\n");
-        UCA0IE |= UCTXIE;
-        iotState = WAITSSID;
-    } else if(iotState == MUX && iot_boot_timer >= 500){
-        strcpy(iot_tx_buf, "AT+CIPMUX=1\r\n");
-        UCA0IE |= UCTXIE;
-        iotState = SERVER;
-    } else if(iotState == STORE && iot_boot_timer >= 300){
-        strcpy(iot_tx_buf, "AT+SYSSTORE=0\r\n");
-        UCA0IE |= UCTXIE;
-        iotState = MUX;
+void iot_commands(void){
+    iot_link_rx();
+    iot_reply_process();
+}
+
+//-----------------------------------------------------------------
+// One contiguous slice of a +IPD payload, still in iot_rx_ring.
+//-----------------------------------------------------------------
+void iot_payload(unsigned char link, const char *data, unsigned int length){
+    unsigned int pos = iot_rx_ring.tail;    // Ring position of data[0]
+
+    while(length--){
+        iot_token(link, *data++, pos++);
     }
+}
 
-    switch(iotState){
-        case SSID:
-            if(read_ptr != iot_rx){
-                if(!startSSID && iot_rx_buf[read_ptr++] == '"'){
-                    startSSID = 1;
-
-                } else if(startSSID == 1){
-                    if(iot_rx_buf[read_ptr] != '"'){
-                        ssidName[ssid_ptr++] = iot_rx_buf[read_ptr++];
-                    } else {
-                        startSSID = 2;
-                    }
-                }
-            }
-
-            if(read_ptr >= sizeof(iot_rx_buf)){
-                read_ptr = BEGINNING;
-            }
-
-
-            if(startSSID == 2){
-                strncpy(display_line[0],ssidName,10);
-                display_changed = TRUE;
-                iotState = WAITIP;
-            }
-
-            break;
-        case IP:
-            if(read_ptr != iot_rx){
-                if(startIP <= 3 && iot_rx_buf[read_ptr++] == '"'){
-                    startIP++;
-
-                } else if(startIP == 4){
-                    if(iot_rx_buf[read_ptr] != '"'){
-                        ipName[ip_ptr++] = iot_rx_buf[read_ptr++];
-                    } else {
-                        startIP = 5;
-                    }
-                }
-            }
-
-            if(read_ptr >= sizeof(iot_rx_buf)){
-                read_ptr = BEGINNING;
-            }
-
-
-            if(startIP == 5){
-                strcpy(display_line[1], "    IP    ");
-                strncpy(display_line[2],ipName, 10);
-                display_line[3][0] = ipName[10];
-                display_line[3][1] = ipName[11];
-                display_line[3][2] = ipName[12];
-                display_line[3][3] = ipName[13];
-                display_line[3][4] = ipName[14];
-                display_changed = TRUE;
-                iotState = NONE;
-            }
-            break;
-        default:
-            break;
+//-----------------------------------------------------------------
+// Commands typed on the USB port, for bench work with or without the
+// ESP32. Everything in usb_rx_ring goes through the same tokenizer as
+// a TCP link. Other bytes are dropped here; in full mirror mode the
+// bridge has already passed them on to the ESP32. The '^' lines are
+// never bridged, see bridge_keep_cmd.
+//-----------------------------------------------------------------
+void usb_commands(void){
+    const char *data;
+    unsigned int length;
+    unsigned int i;
 
+    while((length = ring_peek(&usb_rx_ring, &data)) != 0){
+        for(i = 0; i < length; i++){
+            iot_token(IOT_USB_LINK, data[i], 0);
+        }
+        ring_consume(&usb_rx_ring, length);
     }
 }
 
+//-----------------------------------------------------------------
+// Command tokenizer, one per link
+// A command is '^' followed by its text and ended by '\r' or '\n'.
+// A '^' always starts a new command, throwing away a partial one,
+// and a command too long for the link's buffer is dropped. pos is
+// the byte's place in iot_rx_ring, used to find its RX stamp.
+//-----------------------------------------------------------------
+void iot_token(unsigned char link, char c, unsigned int pos){
+    iot_link *l = &iot_links[link];
+
+    if(c == '^'){
+        l->in_cmd = TRUE;
+        l->cmd_len = 0;
+        l->stamp = link == IOT_USB_LINK ? LAT_NONE : lat_begin(pos);   // RX stamps are IOT only
+        return;
+    }
+    if(!l->in_cmd){
+        return;
+    }
+    if(c == '\r' || c == '\n'){
+        l->cmd[l->cmd_len] = 0;
+        l->in_cmd = FALSE;
+        iot_dispatch(link, l->cmd, l->stamp);
+        return;
+    }
+    if(l->cmd_len < sizeof(l->cmd) - 1){
+        l->cmd[l->cmd_len++] = c;
+    } else {
+        l->in_cmd = FALSE;
+        cmd_overflow++;
+    }
+}
 
 //-----------------------------------------------------------------
-// Command logic sent from Magic Smoke
-// Parse commands sent from IOT, looking for a '^' to signal a valid command
-// Switch statement to determine what each command should do
-//
+// Command handlers, one per table entry. args->arg[0] is already
+// scaled to ticks for the timed moves.
 //-----------------------------------------------------------------
+void cmd_move(const cmd_args *args){
+    motion_add(args->replace, args->opcode, args->arg[0], args->arg[1], args->stamp);
+}
 
-void iot_commands(void){
+void cmd_stop(const cmd_args *args){
+    motion_flush();                     // Stop now, drop anything queued
+}
 
-    if(read_ptr != iot_rx){
-        if(!startCaret && iot_rx_buf[read_ptr++] == '^'){
-            startCaret = 1;
-        } else if(startCaret == 1){
-            if(iot_rx_buf[read_ptr] != '\r'){
-                iotCmd[bigCmd_ptr][smCmd_ptr++] = iot_rx_buf[read_ptr++];
-            } else {
-                startCaret = 2;
-            }
-        }
+void cmd_arrived(const cmd_args *args){
+    P6OUT |= LCD_BACKLITE;
+    strcpy(display_line[0], "ARRIVED 0 ");
+    padNum++;
+    display_line[0][9] = padNum + 0x30;
+    display_changed = TRUE;
+}
+
+void cmd_name(const cmd_args *args){
+    strcpy(display_line[0], "          ");
+    strcpy(display_line[1], "  CHINMAY ");
+    strcpy(display_line[2], "  SHENDE  ");
+    strcpy(display_line[3], "          ");
+    display_changed = TRUE;
+}
+
+void cmd_mirror(const cmd_args *args){
+    char mode = args->arg[0] + 0x30;    // 0 off, 1 full, 2 commands only
+
+    if(mode == MIRROR_FULL && telemetry_period){
+        mode = MIRROR_FILTERED;         // See telemetry_set_period()
     }
-    if(startCaret == 2){
-        if(iotCmd[bigCmd_ptr][0] == '0' && iotCmd[bigCmd_ptr][1] == '0' && iotCmd[bigCmd_ptr][2] == '0' && iotCmd[bigCmd_ptr][3] == '0'){
-
-            if(iotCmd[bigCmd_ptr][4] == 'F'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = FORWARD;
-                timeLength = (iotCmd[bigCmd_ptr][5] - 0x30) * 25;
-                time = 0;
-            } else if(iotCmd[bigCmd_ptr][4] == 'B'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = BACKWARD;
-                timeLength = (iotCmd[bigCmd_ptr][5] - 0x30) * 25;
-                time = 0;
-            } else if(iotCmd[bigCmd_ptr][4] == 'R'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = RIGHT;
-                timeLength = (iotCmd[bigCmd_ptr][5] - 0x30) * 20;
-                time = 0;
-            } else if(iotCmd[bigCmd_ptr][4] == 'L'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = LEFT;
-                timeLength = (iotCmd[bigCmd_ptr][5] - 0x30) * 20;
-                time = 0;
-            } else if (iotCmd[bigCmd_ptr][4] == 'S'){
-                movement = STOP;
-            } else if (iotCmd[bigCmd_ptr][4] == 'C'){
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = BLACKLINE;
-            } else if(iotCmd[bigCmd_ptr][4] == '+'){
-                P6OUT |= LCD_BACKLITE;
-                strcpy(display_line[0], "ARRIVED 0 ");
-                padNum++;
-                display_line[0][9] = padNum + 0x30;
-                display_changed = TRUE;
-            } else if (iotCmd[bigCmd_ptr][4] == 'D'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[1], "  CHINMAY ");
-                strcpy(display_line[2], "  SHENDE  ");
-                strcpy(display_line[3], "          ");
-                display_changed = TRUE;
-            } else if (iotCmd[bigCmd_ptr][4] == 'E'){
-                wait = 0;
-                BLState = EXIT;
-            } else if (iotCmd[bigCmd_ptr][4] == 'P'){
-                P6OUT &= ~LCD_BACKLITE;
-                strcpy(display_line[0], "          ");
-                strcpy(display_line[3], "          ");
-                strcpy(display_line[3], &iotCmd[bigCmd_ptr][4]);
-                display_changed = TRUE;
-                movement = BUMP;
-                timeLength = (iotCmd[bigCmd_ptr][5] - 0x30) * 5;
-                time = 0;
-            }
-        }
-        if(bigCmd_ptr++ >= 2){
-            bigCmd_ptr = 0;
-        }
-        smCmd_ptr = 0;
-        startCaret = 0;
+    bridge_set_mode(mode);
+}
+
+void cmd_baud(const cmd_args *args){
+    iot_set_baud(args->arg[0]);         // baud_table index
+}
+
+void cmd_latency(const cmd_args *args){
+    if(args->arg[0] == LAT_ISRS){
+        isr_prof_report();
+    } else if(args->arg[0] == LAT_TASKS){
+        sched_report();
+    } else if(args->arg[0] == LAT_DUMP){
+        lat_report();
+    } else {
+        lat_ack = args->arg[0];         // Acks off or on
     }
-    if(read_ptr >= sizeof(iot_rx_buf)){
-        read_ptr = BEGINNING;
+}
+
+void cmd_telemetry(const cmd_args *args){
+    telemetry_set_period((unsigned long)args->arg[0] * TELEMETRY_STEP);
+}
+
+// ^0000A<channel>,<filter>, see ADC_FILTER_... in adc.h
+void cmd_filter(const cmd_args *args){
+    if(args->count == 2){
+        adc_set_filter(args->arg[0], args->arg[1]);
     }
-    if(smCmd_ptr >= sizeof(iotCmd[bigCmd_ptr])){
-        smCmd_ptr = 0;
-        if(bigCmd_ptr++ >= 2){
-            bigCmd_ptr = 0;
-        }
+}
+
+// ^0000I<mode>, see ADC_IR_... in adc.h
+void cmd_ir(const cmd_args *args){
+    IR_LED_control(args->arg[0]);
+}
+
+// ^0000Z does what SW1 does while calibrating, see calibrate.c
+void cmd_calibrate(const cmd_args *args){
+    Calibration();
+}
+
+// ^0000V<0|1>, battery compensation of the motor duties off or on
+void cmd_battery(const cmd_args *args){
+    battery_compensation(args->arg[0]);
+}
+
+// ^0000G<command>[,<level>], raw ADC capture, see CAP_CMD_... in capture.h
+void cmd_capture(const cmd_args *args){
+    capture_command(args->arg[0], args->count == 2 ? args->arg[1] : CAP_LEVEL_DEFAULT);
+}
+
+// ^0000W<0|1>, line stops made by ADC_ISR off or on, see edge.c
+void cmd_edge(const cmd_args *args){
+    edge_brake(args->arg[0]);
+}
+
+void cmd_exit(const cmd_args *args){
+    edge_disarm();                      // No brake from a stop the car is leaving
+    bl_move_start = now_ms();
+    BLState = EXIT;
+}
+
+#if MOTION_QUEUE_DEPTH > 99
+#error "cmd_query prints the queued count with two digits at most"
+#endif
+
+//-----------------------------------------------------------------
+// ^0000Q answers with "Q <move> <queued> <line state>\r\n"
+//-----------------------------------------------------------------
+void cmd_query(const cmd_args *args){
+    char reply[12];
+    char *p = reply;
+    unsigned int pending = motion_pending();
+
+    *p++ = 'Q';
+    *p++ = ' ';
+    *p++ = movement;
+    *p++ = ' ';
+    if(pending >= 10){
+        *p++ = '0' + pending / 10;
+    }
+    *p++ = '0' + pending % 10;
+    *p++ = ' ';
+    *p++ = BLState ? BLState : '-';
+    *p++ = '\r';
+    *p++ = '\n';
+    iot_reply(args->link, reply, p - reply);
+}
+
+// Ticks per digit of the timed moves, from the ms in macros.h
+#define STRAIGHT_SCALE      MS_TO_TICKS(MOVE_STRAIGHT_MS)
+#define TURN_SCALE          MS_TO_TICKS(MOVE_TURN_MS)
+#define BUMP_SCALE          MS_TO_TICKS(MOVE_BUMP_MS)
+#define MOVE_MAX(scale)     (32767 / (scale) < 999 ? 32767 / (scale) : 999)   // Short ticks lower it
+#define TELEMETRY_MAX       (SWT_MAX_MS / TELEMETRY_STEP < 999 ? SWT_MAX_MS / TELEMETRY_STEP : 999)
+
+//-----------------------------------------------------------------
+// Dispatch table, indexed by opcode. To add a command give it an
+// entry here; the parser does not change. max * scale must fit in
+// an int. Timed moves take an optional ",<percent>" duty cycle.
+//-----------------------------------------------------------------
+const cmd_entry cmd_table[CMD_TABLE_SIZE] = {
+    //                   handler         arguments                                                     scale           max                       max2
+    [CMD_INDEX('F')] = { cmd_move,      CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_SHOW | CMD_MOVE | CMD_DARK,  STRAIGHT_SCALE, MOVE_MAX(STRAIGHT_SCALE), 100 },
+    [CMD_INDEX('B')] = { cmd_move,      CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_SHOW | CMD_MOVE | CMD_DARK,  STRAIGHT_SCALE, MOVE_MAX(STRAIGHT_SCALE), 100 },
+    [CMD_INDEX('R')] = { cmd_move,      CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_SHOW | CMD_MOVE | CMD_DARK,  TURN_SCALE,     MOVE_MAX(TURN_SCALE),     100 },
+    [CMD_INDEX('L')] = { cmd_move,      CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_SHOW | CMD_MOVE | CMD_DARK,  TURN_SCALE,     MOVE_MAX(TURN_SCALE),     100 },
+    [CMD_INDEX('P')] = { cmd_move,      CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_SHOW | CMD_MOVE | CMD_DARK,  BUMP_SCALE,     MOVE_MAX(BUMP_SCALE),     100 },
+    [CMD_INDEX('C')] = { cmd_move,      CMD_SHOW | CMD_MOVE,                                          0,              0,                        0 },
+    [CMD_INDEX('S')] = { cmd_stop,      CMD_ARG_NONE,                                                 0,              0,                        0 },
+    [CMD_INDEX('+')] = { cmd_arrived,   CMD_ARG_NONE,                                                 0,              0,                        0 },
+    [CMD_INDEX('D')] = { cmd_name,      CMD_DARK,                                                     0,              0,                        0 },
+    [CMD_INDEX('E')] = { cmd_exit,      CMD_ARG_NONE,                                                 0,              0,                        0 },
+    [CMD_INDEX('M')] = { cmd_mirror,    CMD_ARG_NUM,                                                  0,              2,                        0 },
+    [CMD_INDEX('U')] = { cmd_baud,      CMD_ARG_NUM,                                                  0,              BAUD_COUNT - 1,           0 },
+    [CMD_INDEX('T')] = { cmd_telemetry, CMD_ARG_NUM,                                                  0,              TELEMETRY_MAX,            0 },
+    [CMD_INDEX('Q')] = { cmd_query,     CMD_ANY_LINK,                                                 0,              0,                        0 },
+    [CMD_INDEX('K')] = { cmd_latency,   CMD_ARG_NUM | CMD_ANY_LINK,                                   0,              LAT_ISRS,                 0 },
+    [CMD_INDEX('A')] = { cmd_filter,    CMD_ARG_NUM | CMD_ARG_OPT2,                                   0,              ADC_CHANNELS - 1,         ADC_FILTER_COUNT - 1 },
+    [CMD_INDEX('I')] = { cmd_ir,        CMD_ARG_NUM,                                                  0,              ADC_IR_COUNT - 1,         0 },
+    [CMD_INDEX('Z')] = { cmd_calibrate, CMD_ARG_NONE,                                                 0,              0,                        0 },
+    [CMD_INDEX('V')] = { cmd_battery,   CMD_ARG_NUM,                                                  0,              1,                        0 },
+    [CMD_INDEX('W')] = { cmd_edge,      CMD_ARG_NUM,                                                  0,              1,                        0 },
+    [CMD_INDEX('G')] = { cmd_capture,   CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_ANY_LINK,                    0,              CAP_CMD_COUNT - 1,        CAP_LEVEL_MAX },
+};
+
+const char cmd_key[] = CMD_KEY;
+
+//-----------------------------------------------------------------
+// Parses one complete command and runs its handler. Commands with
+// the wrong key, an unknown opcode or bad arguments are counted and
+// dropped. Only the controller link may drive the car; other links
+// are told BUSY unless the entry allows any link. The USB port is
+// the bench console and may always drive it.
+//-----------------------------------------------------------------
+void iot_dispatch(unsigned char link, char *command, unsigned char stamp){
+    const cmd_entry *entry;
+    cmd_args args;
+
+    if(cmd_parse(command, cmd_key, cmd_table, &args) != CMD_OK){
+        cmd_rejected++;
+        return;
+    }
+    args.link = link;
+    args.stamp = stamp;
+    entry = &cmd_table[CMD_INDEX(args.opcode)];
+    if(iot_controller == IOT_NO_LINK && link != IOT_USB_LINK){
+        iot_controller = link;          // Connected before boot finished
+        iot_links[link].open = TRUE;
+    }
+    if(link != iot_controller && link != IOT_USB_LINK && !(entry->flags & CMD_ANY_LINK)){
+        iot_links[link].rejected++;
+        iot_reply(link, "BUSY\r\n", 6);
+        return;
+    }
+    lat_parsed(stamp, link, args.opcode);
+    if(entry->flags & CMD_DARK){
+        P6OUT &= ~LCD_BACKLITE;
+    }
+    if(entry->flags & CMD_SHOW){
+        strcpy(display_line[0], "          ");
+        strcpy(display_line[3], "          ");
+        strncpy(display_line[3], args.text, 10);
+        display_changed = TRUE;
+    }
+    entry->handler(&args);
+    if(!(entry->flags & CMD_MOVE)){
+        lat_applied(stamp);             // Moves are stamped by movement_machine
     }
 }
 
-void movement_machine(void){
-    switch(movement){
-        case FORWARD:
-            if(time <= timeLength){
-                forward_fast();
-            } else {
-                turn_off_motors();
-                movement = NONE;
-            }
-            break;
-        case BACKWARD:
-            if(time <= timeLength){
-                reverse_fast();
-            } else {
-                turn_off_motors();
-                movement = NONE;
-            }
-            break;
-        case LEFT:
-            if(time <= timeLength){
-                turn_right();
-            } else {
-                turn_off_motors();
-                movement = NONE;
-            }
-            break;
-        case RIGHT:
-            if(time <= timeLength){
-               turn_left();
-            } else {
-                turn_off_motors();
-                movement = NONE;
-            }
-            break;
-        case STOP:
-            turn_off_motors();
-            movement = NONE;
-            break;
-        case BLACKLINE:
-            BlackLineIntercept();
-            break;
-        case BUMP:
-            if(time <= timeLength){
-                turn_left();
-            } else {
-                turn_off_motors();
-                movement = NONE;
-            }
-            break;
-        default:
-            break;
+//-----------------------------------------------------------------
+// Moves are appended to the queue unless the command asked for the
+// queue to be replaced. A full queue is shown on the display.
+//-----------------------------------------------------------------
+void motion_add(char replace, char move, unsigned int duration, unsigned char duty,
+                unsigned char stamp){
+    if(replace){
+        motion_replace(move, duration, duty, stamp);
+    } else if(!motion_append(move, duration, duty, stamp)){
+        strcpy(display_line[0], "QUEUE FULL");
+        display_changed = TRUE;
     }
 }
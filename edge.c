@@ -0,0 +1,230 @@
+/*
+ * edge.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file finds the line edges with the ADC window comparator
+ *  instead of waiting for the main loop to poll the detectors. As
+ *  ADC_ISR sets up each slot, edge_window loads ADCHI and ADCLO with
+ *  that detector's calibrated high and low thresholds. Only one
+ *  interrupt is enabled: HI while the detector is off the line and LO
+ *  while it is on it. That gives the same hysteresis as cal_black().
+ *  Slots with the emitter off, and the thumbwheel and rail slots, have
+ *  the comparator interrupts turned off.
+ *
+ *  The thresholds are in snapshot units and the comparator sees raw
+ *  conversions. In ADC_IR_SYNC a snapshot value is the emitter-on
+ *  conversion plus the ambient figure, so the ambient is taken off the
+ *  thresholds first. In the other modes they are just scaled.
+ *
+ *  Each crossing is stamped with the time its sample was taken, from
+ *  TB1R, which counts from the TB1.1 edge that started the
+ *  conversion. While the line state machine has it armed, a crossing
+ *  onto the line stops the motors in the ISR. The time from that sample
+ *  to the brake is kept as the detection to brake latency. With ^0000W0
+ *  the state machine brakes when it next polls, and the latency is
+ *  measured from the same comparator stamp, so the two can be
+ *  compared. Each stop is reported in an edge telemetry frame.
+ *
+ *  Functions included:
+ *    - Init_Edge: Clears the edge state and the brake statistics.
+ *    - edge_window: ISR side, sets up the comparator for the next slot.
+ *    - edge_crossing: ISR side, stamps a crossing and brakes if armed.
+ *    - edge_arm: Lets a crossing of the given detectors stop the car.
+ *    - edge_disarm: Stops braking without a report.
+ *    - edge_run: Runs a motor move unless the ISR has braked.
+ *    - edge_stop: Ends a brake, measures the main loop's latency.
+ *    - edge_brake: Turns the ISR brake on or off.
+ *    - edge_process: Sends the edge frame of the last stop.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "adc.h"
+#include "calibrate.h"
+#include "edge.h"
+
+volatile unsigned char edge_state;
+unsigned char edge_armed;               // EDGE_... that brake while armed
+char edge_brake_on;
+char edge_black[ADC_DETECTORS];         // Comparator's view, flipped at each crossing
+unsigned char edge_channel;             // Detector in the slot being converted, EDGE_UNKNOWN if none
+unsigned long edge_sample_us[ADC_DETECTORS];   // Last crossing onto the line
+unsigned int edge_crossings[ADC_DETECTORS];
+unsigned char edge_first;               // First detector to cross since arming
+unsigned long edge_first_us;
+unsigned long edge_stop_us;             // Sample that the last stop was for
+unsigned char edge_source;              // EDGE_SRC_... of the last stop
+unsigned char edge_detector;
+unsigned int edge_latency;              // us, sample to brake
+unsigned int edge_brakes;               // Stops made by the ISR
+unsigned int edge_min;
+unsigned int edge_max;
+char edge_report_due;
+
+void Init_Edge(void){
+    edge_state = EDGE_IDLE;
+    edge_brake_on = EDGE_BRAKE_DEFAULT;
+    edge_channel = EDGE_UNKNOWN;
+    memset(edge_black, 0, sizeof(edge_black));
+    memset(edge_crossings, 0, sizeof(edge_crossings));
+    edge_brakes = 0;
+    edge_min = 0xFFFF;
+    edge_max = 0;
+    edge_report_due = FALSE;
+}
+
+//-----------------------------------------------------------------
+// From ADC_ISR while ENC is off, for the slot just programmed. The
+// flags of earlier slots are cleared so they cannot fire when the
+// interrupt is enabled again.
+//-----------------------------------------------------------------
+void edge_window(unsigned char channel, unsigned char off, unsigned int ambient){
+    const cal_sensor *cal;
+
+    ADCIE &= ~(ADCHIIE | ADCLOIE | ADCINIE);
+    ADCIFG &= ~(ADCHIIFG | ADCLOIFG | ADCINIFG);
+    if(channel >= ADC_DETECTORS || off){
+        edge_channel = EDGE_UNKNOWN;
+        return;
+    }
+    cal = &cal_active[channel];
+    ADCHI = cal->high > ambient ? (cal->high - ambient) >> (ADC_SNAP_BITS - 12) : 0;
+    ADCLO = cal->low > ambient ? (cal->low - ambient) >> (ADC_SNAP_BITS - 12) : 0;
+    edge_channel = channel;
+    ADCIE |= edge_black[channel] ? ADCLOIE : ADCHIIE;
+}
+
+//-----------------------------------------------------------------
+// ADCHIIFG (high TRUE) or ADCLOIFG. These come ahead of ADCIFG for
+// the same conversion, so edge_channel is still its detector. TB1R
+// is the us since the sample started, as long as the ISR runs in
+// the same slot, which it has to for the conversion to be kept.
+//-----------------------------------------------------------------
+void edge_crossing(char high){
+    unsigned char channel = edge_channel;
+    unsigned int since = TB1R;
+    unsigned long sample = now_us() - since - 1;
+    unsigned int latency;
+
+    if(channel == EDGE_UNKNOWN){
+        return;
+    }
+    edge_black[channel] = high;
+    if(!high){
+        return;
+    }
+    edge_crossings[channel]++;
+    edge_sample_us[channel] = sample;
+    if(edge_state != EDGE_ARMED || !(edge_armed & (1 << channel))){
+        return;
+    }
+    if(edge_first == EDGE_UNKNOWN){
+        edge_first = channel;
+        edge_first_us = sample;
+    }
+    if(!edge_brake_on){
+        return;
+    }
+
+    turn_off_motors();
+    latency = now_us() - sample;
+    edge_state = EDGE_BRAKED;
+    edge_source = EDGE_SRC_ISR;
+    edge_detector = channel;
+    edge_latency = latency;
+    edge_brakes++;
+    if(latency < edge_min){
+        edge_min = latency;
+    }
+    if(latency > edge_max){
+        edge_max = latency;
+    }
+}
+
+void edge_arm(unsigned char detectors){
+    if(edge_state != EDGE_IDLE){
+        return;                         // Already armed, or waiting for edge_stop()
+    }
+    edge_armed = detectors;
+    edge_first = EDGE_UNKNOWN;
+    edge_state = EDGE_ARMED;
+}
+
+void edge_disarm(void){
+    edge_state = EDGE_IDLE;
+}
+
+//-----------------------------------------------------------------
+// The line state machine drives the motors again on every pass.
+// Doing it with interrupts off means a brake can never be undone
+// by a move that was already on its way. TRUE if it was braked.
+//-----------------------------------------------------------------
+char edge_run(void (*move)(void)){
+    char braked;
+
+    __disable_interrupt();
+    braked = edge_state == EDGE_BRAKED;
+    if(!braked){
+        move();
+    }
+    __enable_interrupt();
+    return braked;
+}
+
+//-----------------------------------------------------------------
+// Called once the state machine has stopped on the line, whoever
+// braked. If the ISR did not, the latency is from the comparator's
+// first crossing to now, or unknown if it saw none.
+//-----------------------------------------------------------------
+void edge_stop(void){
+    unsigned long since;
+
+    __disable_interrupt();
+    if(edge_state == EDGE_ARMED){
+        edge_source = EDGE_SRC_LOOP;
+        edge_detector = edge_first;
+        since = now_us() - edge_first_us;
+        edge_latency = edge_first == EDGE_UNKNOWN ? 0xFFFF : since < 0xFFFF ? since : 0xFFFF;
+    }
+    if(edge_state != EDGE_IDLE){
+        edge_stop_us = edge_first_us;
+        edge_report_due = TRUE;
+    }
+    edge_state = EDGE_IDLE;
+    __enable_interrupt();
+}
+
+void edge_brake(char on){
+    edge_brake_on = on;
+}
+
+//-----------------------------------------------------------------
+// From Telemetry_Process, kept until a frame buffer is free.
+//-----------------------------------------------------------------
+void edge_process(void){
+    unsigned char payload[TLM_EDGE_LEN];
+
+    if(!edge_report_due || !telemetry_ready()){
+        return;
+    }
+    payload[TLM_ED_SOURCE] = edge_source;
+    payload[TLM_ED_DETECTOR] = edge_detector;
+    put_u16(&payload[TLM_ED_LATENCY], edge_latency);
+    put_u32(&payload[TLM_ED_SAMPLE_US], edge_detector == EDGE_UNKNOWN ? 0 : edge_stop_us);
+    put_u16(&payload[TLM_ED_BRAKES], edge_brakes);
+    put_u16(&payload[TLM_ED_MIN], edge_brakes ? edge_min : 0);
+    put_u16(&payload[TLM_ED_MAX], edge_max);
+    put_u16(&payload[TLM_ED_CROSS_L], edge_crossings[ADC_LEFT]);
+    put_u16(&payload[TLM_ED_CROSS_R], edge_crossings[ADC_RIGHT]);
+    edge_report_due = !telemetry_send(TLM_TYPE_EDGE, payload, TLM_EDGE_LEN);
+}
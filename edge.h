@@ -0,0 +1,47 @@
+/*
+ * edge.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Line edges from the ADC window comparator. ADC_ISR loads ADCHI and
+ *  ADCLO with the calibrated thresholds of the detector in each slot,
+ *  so a crossing interrupts as soon as its conversion is done. While
+ *  armed a crossing onto the line stops the motors in the ISR.
+ *  Include after adc.h.
+ */
+
+#ifndef EDGE_H_
+#define EDGE_H_
+
+// edge_arm() detectors, 1 << ADC_LEFT and 1 << ADC_RIGHT
+#define EDGE_LEFT           (0x01)
+#define EDGE_RIGHT          (0x02)
+#define EDGE_BOTH           (EDGE_LEFT | EDGE_RIGHT)
+
+// edge_state
+#define EDGE_IDLE           (0)
+#define EDGE_ARMED          (1)     // Next crossing onto the line brakes
+#define EDGE_BRAKED         (2)     // ADC_ISR stopped the motors, see edge_stop()
+
+#ifndef EDGE_BRAKE_DEFAULT
+#define EDGE_BRAKE_DEFAULT  (1)     // ^0000W0 leaves the stop to the main loop
+#endif
+
+#define EDGE_SRC_ISR        (0)     // TLM_ED_SOURCE, braked by ADC_ISR
+#define EDGE_SRC_LOOP       (1)     // Braked by the line state machine
+#define EDGE_UNKNOWN        (0xFF)
+
+extern volatile unsigned char edge_state;
+extern unsigned long edge_sample_us[ADC_DETECTORS];   // now_us() of each detector's last crossing onto the line
+
+void edge_window(unsigned char channel, unsigned char off, unsigned int ambient);
+void edge_crossing(char high);
+void edge_arm(unsigned char detectors);
+void edge_disarm(void);
+char edge_run(void (*move)(void));
+void edge_stop(void);
+void edge_brake(char on);
+void edge_process(void);
+
+#endif /* EDGE_H_ */
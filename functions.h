@@ -1,187 +1,219 @@
-//******************************************************************************
-//
-//  Description: This file contains the Function prototypes
-//
-//  Chinmay Shende
-//  Jan 2025
-//  Built with IAR Embedded Workbench Version: V4.10A/W32 (5.40.1)
-//******************************************************************************
-// Functions
-
-// Main
-void main(void);
-
-// Initialization
-void Init_Conditions(void);
-
-// Interrupts
-void enable_interrupts(void);
-__interrupt void Timer0_B0_ISR(void);
-__interrupt void switch_interrupt(void);
-
-// Analog to Digital Converter
-void Init_ADC(void);
-void Init_DAC(void);
-
-// Clocks
-void Init_Clocks(void);
-
-// LED Configurations
-void Init_LEDs(void);
-void IR_LED_control(char selection);
-void Backlite_control(char selection);
-
-  // LCD
-void Display_Process(void);
-void Display_Update(char p_L1,char p_L2,char p_L3,char p_L4);
-void enable_display_update(void);
-void update_string(char *string_data, int string);
-void Init_LCD(void);
-void lcd_clear(void);
-void lcd_putc(char c);
-void lcd_puts(char *s);
-
-void lcd_power_on(void);
-void lcd_write_line1(void);
-void lcd_write_line2(void);
-//void lcd_draw_time_page(void);
-//void lcd_power_off(void);
-void lcd_enter_sleep(void);
-void lcd_exit_sleep(void);
-//void lcd_write(unsigned char c);
-//void out_lcd(unsigned char c);
-
-void Write_LCD_Ins(char instruction);
-void Write_LCD_Data(char data);
-void ClrDisplay(void);
-void ClrDisplay_Buffer_0(void);
-void ClrDisplay_Buffer_1(void);
-void ClrDisplay_Buffer_2(void);
-void ClrDisplay_Buffer_3(void);
-
-void SetPostion(char pos);
-void DisplayOnOff(char data);
-void lcd_BIG_mid(void);
-void lcd_BIG_bot(void);
-void lcd_120(void);
-
-void lcd_4line(void);
-void lcd_out(char *s, char line, char position);
-void lcd_rotate(char view);
-
-//void lcd_write(char data, char command);
-void lcd_write(unsigned char c);
-void lcd_write_line1(void);
-void lcd_write_line2(void);
-void lcd_write_line3(void);
-
-void lcd_command( char data);
-void LCD_test(void);
-void LCD_iot_meassage_print(int nema_index);
-
-// Menu
-void Menu_Process(void);
-
-// Ports
-void Init_Ports(void);
-void Init_Port1(void);
-void Init_Port2(void);
-//void Init_Port3(char smclk);
-void Init_Port3(void);
-void Init_Port4(void);
-void Init_Port5(void);
-void Init_Port6(void);
-
-// SPI
-void Init_SPI_B1(void);
-void SPI_B1_write(char byte);
-void spi_rs_data(void);
-void spi_rs_command(void);
-void spi_LCD_idle(void);
-void spi_LCD_active(void);
-void SPI_test(void);
-void WriteIns(char instruction);
-void WriteData(char data);
-
-// Switches
-void Init_Switches(void);
-void switch_control(void);
-void enable_switch_SW1(void);
-void enable_switch_SW2(void);
-void disable_switch_SW1(void);
-void disable_switch_SW2(void);
-void Switches_Process(void);
-void Init_Switch(void);
-void Switch_Process(void);
-void Switch1_Process(void);
-void Switch2_Process(void);
-void menu_act(void);
-void menu_select(void);
-
-// Timers
-void Init_Timers(void);
-void Init_Timer_B0(void);
-void Init_Timer_B1(void);
-void Init_Timer_B2(void);
-void Init_Timer_B3(void);
-
-void usleep(unsigned int usec);
-void usleep10(unsigned int usec);
-void five_msec_sleep(unsigned int msec);
-void measure_delay(void);
-void out_control_words(void);
-
-//Wheels & Motors
-void turn_off_motors(void);
-void turn_on_forward(void);
-void turn_on_reverse(void);
-void spin_counterclockwise(void);
-void spin_clockwise(void);
-void turn(void);
-void turn_left(void);
-void turn_right(void);
-
-void forward_fast(void);
-void reverse_fast(void);
-
-void forward_medium(void);
-void spin_clockwise_medium(void);
-
-
-void Run_Straight(void);
-void Run_Circle(void);
-void Run_Figure_Eight(void);
-void Run_Triangle(void);
-void Run_Timer(void);
-void run_timer_case(void);
-void run_straight_case(void);
-void run_circle_case(void);
-void run_figure_eight_case(void);
-void run_triangle_case(void);
-void wait_case(void);
-void start_case(void);
-void end_case(void);
-void detect_black_line(void);
-
-//HextoBCD
-void HEXtoBCD(int hex_value);
-void adc_line(char line, char location);
-
-void Init_Serial_UCA0(char speed);
-void Init_Serial(void);
-void Init_Serial_UCA1(char speed);
-
-void iot_commands(void);
-void bootIOT(void);
-void movement_machine();
-
-void Init_DAC(void);
-
-void run_menu(void);
-void init_menu(void);
-
-void BlackLineIntercept(void);
-void Calibration(void);
-
-
-
+//******************************************************************************
+//
+//  Description: This file contains the Function prototypes
+//
+//  Chinmay Shende
+//  Jan 2025
+//  Built with IAR Embedded Workbench Version: V4.10A/W32 (5.40.1)
+//******************************************************************************
+// Functions
+
+// Main
+void main(void);
+void Seconds_Process(void);
+
+// Initialization
+void Init_Conditions(void);
+
+// Interrupts
+void enable_interrupts(void);
+__interrupt void Timer0_B0_ISR(void);
+__interrupt void switch_interrupt(void);
+
+// Analog to Digital Converter
+void Init_ADC(void);
+void Init_DAC(void);
+
+// Clocks
+void Init_Clocks(void);
+
+// LED Configurations
+void Init_LEDs(void);
+void IR_LED_control(char selection);
+void Backlite_control(char selection);
+
+  // LCD
+void Display_Process(void);
+void Display_Update(char p_L1,char p_L2,char p_L3,char p_L4);
+void enable_display_update(void);
+void update_string(char *string_data, int string);
+void Init_LCD(void);
+void lcd_clear(void);
+void lcd_putc(char c);
+void lcd_puts(char *s);
+
+void lcd_power_on(void);
+void lcd_write_line1(void);
+void lcd_write_line2(void);
+//void lcd_draw_time_page(void);
+//void lcd_power_off(void);
+void lcd_enter_sleep(void);
+void lcd_exit_sleep(void);
+//void lcd_write(unsigned char c);
+//void out_lcd(unsigned char c);
+
+void Write_LCD_Ins(char instruction);
+void Write_LCD_Data(char data);
+void ClrDisplay(void);
+void ClrDisplay_Buffer_0(void);
+void ClrDisplay_Buffer_1(void);
+void ClrDisplay_Buffer_2(void);
+void ClrDisplay_Buffer_3(void);
+
+void SetPostion(char pos);
+void DisplayOnOff(char data);
+void lcd_BIG_mid(void);
+void lcd_BIG_bot(void);
+void lcd_120(void);
+
+void lcd_4line(void);
+void lcd_out(char *s, char line, char position);
+void lcd_rotate(char view);
+
+//void lcd_write(char data, char command);
+void lcd_write(unsigned char c);
+void lcd_write_line1(void);
+void lcd_write_line2(void);
+void lcd_write_line3(void);
+
+void lcd_command( char data);
+void LCD_test(void);
+void LCD_iot_meassage_print(int nema_index);
+
+// Menu
+void Menu_Process(void);
+
+// Ports
+void Init_Ports(void);
+void Init_Port1(void);
+void Init_Port2(void);
+//void Init_Port3(char smclk);
+void Init_Port3(void);
+void Init_Port4(void);
+void Init_Port5(void);
+void Init_Port6(void);
+
+// SPI
+void Init_SPI_B1(void);
+void SPI_B1_write(char byte);
+void spi_rs_data(void);
+void spi_rs_command(void);
+void spi_LCD_idle(void);
+void spi_LCD_active(void);
+void SPI_test(void);
+void WriteIns(char instruction);
+void WriteData(char data);
+
+// Switches
+void Init_Switches(void);
+void switch_control(void);
+void enable_switch_SW1(void);
+void enable_switch_SW2(void);
+void disable_switch_SW1(void);
+void disable_switch_SW2(void);
+void Switches_Process(void);
+void Init_Switch(void);
+void Switch_Process(void);
+void Switch1_Process(void);
+void Switch2_Process(void);
+void menu_act(void);
+void menu_select(void);
+
+// Timers
+void Init_Timers(void);
+void Init_Timer_B0(void);
+void Init_Timer_B1(void);
+void Init_Timer_B2(void);
+void Init_Timer_B3(void);
+
+void usleep(unsigned int usec);
+void usleep10(unsigned int usec);
+void five_msec_sleep(unsigned int msec);
+void measure_delay(void);
+void out_control_words(void);
+
+//Wheels & Motors
+void turn_off_motors(void);
+void turn_on_forward(void);
+void turn_on_reverse(void);
+void spin_counterclockwise(void);
+void spin_clockwise(void);
+void turn(void);
+void turn_left(void);
+void turn_right(void);
+
+void forward_fast(void);
+void reverse_fast(void);
+
+void forward_medium(void);
+void spin_clockwise_medium(void);
+void set_motor_speeds(int left, int right);
+
+
+void Run_Straight(void);
+void Run_Circle(void);
+void Run_Figure_Eight(void);
+void Run_Triangle(void);
+void Run_Timer(void);
+void run_timer_case(void);
+void run_straight_case(void);
+void run_circle_case(void);
+void run_figure_eight_case(void);
+void run_triangle_case(void);
+void wait_case(void);
+void start_case(void);
+void end_case(void);
+void detect_black_line(void);
+
+//HextoBCD
+void HEXtoBCD(int hex_value);
+void adc_line(char line, char location);
+
+void Init_Serial_UCA0(char speed);
+void Init_Serial(void);
+void Init_Serial_UCA1(char speed);
+void USCI_A0_transmit(void);
+char iot_send(const char *data, unsigned int length, volatile unsigned char *done);
+char iot_send_str(const char *string);
+char usb_send(const char *data, unsigned int length, volatile unsigned char *done);
+char usb_send_str(const char *string);
+char iot_set_baud(char speed);
+void Serial_Process(void);
+
+// Telemetry
+void Init_Telemetry(void);
+void Telemetry_Process(void);
+void telemetry_set_period(unsigned long period);
+char telemetry_send(unsigned char type, const unsigned char *payload, unsigned int length);
+char telemetry_ready(void);
+unsigned int crc16(const unsigned char *data, unsigned int length, unsigned int crc);
+unsigned int cobs_encode(const unsigned char *src, unsigned int length, unsigned char *dest);
+void put_u16(unsigned char *dest, unsigned int value);
+void put_u32(unsigned char *dest, unsigned long value);
+
+void iot_commands(void);
+void usb_commands(void);
+void iot_payload(unsigned char link, const char *data, unsigned int length);
+void iot_token(unsigned char link, char c, unsigned int pos);
+void iot_dispatch(unsigned char link, char *command, unsigned char stamp);
+void Init_IOT(void);
+void bootIOT(void);
+void movement_machine(void);
+void motion_add(char replace, char move, unsigned int duration, unsigned char duty,
+                unsigned char stamp);
+
+void Init_DAC(void);
+
+void run_menu(void);
+void init_menu(void);
+
+void BlackLineIntercept(void);
+void Calibration(void);
+void Init_Calibration(void);
+void Calibration_Process(void);
+void Init_Battery(void);
+void Battery_Process(void);
+void Init_Edge(void);
+
+
+
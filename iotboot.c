@@ -0,0 +1,250 @@
+/*
+ * iotboot.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file brings up the ESP32 after reset. The AT commands in
+ *  boot_steps are sent one at a time, and the next one goes out as
+ *  soon as the module answers OK instead of at a fixed time. ERROR or
+ *  a step timing out resends the command after a short delay, up to
+ *  the step's retry count. The SSID and IP address are taken from the
+ *  replies and shown on the display, and the total boot time is kept
+ *  in iot_boot_ms for telemetry.
+ *
+ *  Functions included:
+ *    - Init_IOT: Holds the ESP32 in reset and starts the boot timer.
+ *    - bootIOT: Runs the boot sequence, then hands the link to
+ *      iot_commands.
+ *    - boot_line: Checks one reply line against the current step.
+ *    - boot_quoted: Copies the first quoted string out of a line.
+ *    - boot_show: Puts the SSID and IP address on the display.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "LCD.h"
+#include "ports.h"
+#include "macros.h"
+#include "ringbuf.h"
+#include "swtimer.h"
+#include "timebase.h"
+
+extern volatile unsigned char display_changed;
+extern char display_line[4][11];
+extern ring_buf iot_rx_ring;
+extern unsigned int timer_start;
+
+typedef struct {
+    const char *command;        // NULL = nothing to send, just wait
+    const char *reply;          // Line that ends the step
+    const char *data;           // Line to capture before reply, or NULL
+    unsigned int timeout;       // ms to wait for reply
+    unsigned char retries;      // Resends before giving up
+    char optional;              // TRUE = give up by moving on
+} boot_step;
+
+//-----------------------------------------------------------------
+// The module prints "ready" once its firmware is up. If that was
+// missed the AT probe finds it anyway. CWJAP? is repeated until the
+// module has joined the access point it remembers.
+//-----------------------------------------------------------------
+const boot_step boot_steps[] = {
+    { NULL,                       "ready", NULL,            3000, 0,  TRUE  },
+    { "AT\r\n",                   "OK",    NULL,            500,  10, FALSE },
+    { "AT+SYSSTORE=0\r\n",        "OK",    NULL,            1000, 3,  FALSE },
+    { "AT+CIPMUX=1\r\n",          "OK",    NULL,            1000, 3,  FALSE },
+    { "AT+CIPSERVER=1,22222\r\n", "OK",    NULL,            1000, 3,  FALSE },
+    { "AT+CWJAP?\r\n",            "OK",    "+CWJAP:",       1000, 30, FALSE },
+    { "AT+CIFSR\r\n",             "OK",    "+CIFSR:STAIP,", 1000, 5,  FALSE },
+};
+#define BOOT_STEPS (sizeof(boot_steps) / sizeof(boot_steps[0]))
+#define BOOT_CWJAP (5)
+#define BOOT_CIFSR (6)
+
+char iotState;                          // IOT_RESET, IOT_SEND, IOT_WAIT, ...
+unsigned int boot_step_index;
+unsigned int boot_attempt;
+sw_timer iot_boot_timer;                // Reset delay, step timeout or retry delay
+unsigned long boot_began;               // now_ms() at the reset
+char boot_have_data;
+unsigned int boot_retries;              // Resends over the whole boot
+unsigned int iot_boot_ms;               // Reset to server ready, 0 = not yet
+
+char boot_line_buf[48];
+unsigned int boot_line_len;
+
+char ssidName[20];
+char ipName[20];
+
+void boot_line(char *line);
+void boot_quoted(const char *line, char *dest, unsigned int size);
+void boot_show(void);
+
+void Init_IOT(void){
+    iotState = IOT_RESET;
+    boot_began = now_ms();
+    swt_start(&iot_boot_timer, MS_TO_TICKS(IOT_EN_DELAY), SWT_ONE_SHOT);
+}
+
+void bootIOT(void){
+    const boot_step *step;
+    const char *data;
+    unsigned int length;
+    unsigned int i;
+    char c;
+
+    switch(iotState){
+        case IOT_RESET:
+            if(swt_running(&iot_boot_timer)){
+                return;
+            }
+            P3OUT |= IOT_EN;
+            P3OUT |= IOT_LINK_GRN;
+            boot_step_index = 0;
+            boot_attempt = 0;
+            boot_retries = 0;
+            boot_line_len = 0;
+            iot_boot_ms = 0;
+            iotState = IOT_SEND;
+            break;
+
+        case IOT_RETRY:
+            if(swt_running(&iot_boot_timer)){
+                break;                  // Still reading, replies are thrown away
+            }
+            iotState = IOT_SEND;
+            // fall through
+        case IOT_SEND:
+            step = &boot_steps[boot_step_index];
+            if(step->command && !iot_send_str(step->command)){
+                return;                 // TX queue full, try next pass
+            }
+            swt_start(&iot_boot_timer, MS_TO_TICKS(step->timeout), SWT_ONE_SHOT);
+            boot_have_data = FALSE;
+            iotState = IOT_WAIT;
+            break;
+
+        case IOT_WAIT:
+            if(!swt_running(&iot_boot_timer)){
+                boot_line("");          // Treated like an ERROR
+            }
+            break;
+
+        case IOT_READY:
+        case IOT_FAILED:
+            iot_commands();
+            timer_start = 1;
+            return;
+
+        default:
+            return;
+    }
+
+    // Assemble reply lines while the sequence is running
+    while(iotState != IOT_READY && iotState != IOT_FAILED &&
+          (length = ring_peek(&iot_rx_ring, &data)) != 0){
+        for(i = 0; i < length; i++){
+            c = data[i];
+            if(c == '\r'){
+                continue;
+            }
+            if(c != '\n'){
+                if(boot_line_len < sizeof(boot_line_buf) - 1){
+                    boot_line_buf[boot_line_len++] = c;
+                }
+                continue;
+            }
+            boot_line_buf[boot_line_len] = 0;
+            if(boot_line_len && iotState == IOT_WAIT){
+                boot_line(boot_line_buf);
+            }
+            boot_line_len = 0;
+            if(iotState == IOT_READY || iotState == IOT_FAILED){
+                i++;
+                break;                  // Anything after belongs to iot_commands
+            }
+        }
+        ring_consume(&iot_rx_ring, i);
+    }
+}
+
+//-----------------------------------------------------------------
+// Moves the sequence on when line finishes the current step. An
+// empty line means the step timed out.
+//-----------------------------------------------------------------
+void boot_line(char *line){
+    const boot_step *step = &boot_steps[boot_step_index];
+    unsigned long ms;
+
+    if(step->data && !strncmp(line, step->data, strlen(step->data))){
+        if(boot_step_index == BOOT_CWJAP){
+            boot_quoted(line, ssidName, sizeof(ssidName));
+        } else if(boot_step_index == BOOT_CIFSR){
+            boot_quoted(line, ipName, sizeof(ipName));
+        }
+        boot_have_data = TRUE;
+        return;
+    }
+
+    if(line[0] && !strcmp(line, step->reply) && (!step->data || boot_have_data)){
+        boot_attempt = 0;
+        if(++boot_step_index >= BOOT_STEPS){
+            ms = MS_SINCE(boot_began);
+            iot_boot_ms = ms < 0xFFFF ? ms : 0xFFFF;
+            boot_show();
+            iotState = IOT_READY;
+        } else {
+            iotState = IOT_SEND;
+        }
+        return;
+    }
+
+    // OK without the data asked for (not joined yet), ERROR or timeout
+    if(line[0] && strcmp(line, step->reply) && strcmp(line, "ERROR") && strcmp(line, "FAIL")){
+        return;                         // Echo or some other message
+    }
+    if(boot_attempt++ < step->retries){
+        boot_retries++;
+        swt_start(&iot_boot_timer, MS_TO_TICKS(IOT_RETRY_DELAY), SWT_ONE_SHOT);
+        iotState = IOT_RETRY;
+    } else if(step->optional){
+        boot_attempt = 0;
+        boot_step_index++;
+        iotState = IOT_SEND;
+    } else {
+        strcpy(display_line[0], "IOT FAILED");
+        display_changed = TRUE;
+        iotState = IOT_FAILED;
+    }
+}
+
+void boot_quoted(const char *line, char *dest, unsigned int size){
+    unsigned int n = 0;
+
+    line = strchr(line, '"');
+    if(line){
+        line++;
+        while(*line && *line != '"' && n < size - 1){
+            dest[n++] = *line++;
+        }
+    }
+    dest[n] = 0;
+}
+
+void boot_show(void){
+    unsigned int i;
+
+    strncpy(display_line[0], ssidName, 10);
+    strcpy(display_line[1], "    IP    ");
+    strncpy(display_line[2], ipName, 10);
+    for(i = 0; i < 5 && ipName[10 + i]; i++){
+        display_line[3][i] = ipName[10 + i];
+    }
+    display_changed = TRUE;
+}
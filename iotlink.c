@@ -0,0 +1,327 @@
+/*
+ * iotlink.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file splits the ESP32's receive stream into link events and
+ *  client payloads. A "+IPD,<link>,<length>:" header is read, and then
+ *  exactly <length> bytes are handed to iot_payload straight out of
+ *  iot_rx_ring, one contiguous block at a time, without copying.
+ *  Payloads from different clients cannot be mixed up, and a '^' in
+ *  one is never mistaken for module output. CONNECT and CLOSED lines
+ *  keep track of which links are open. The first client to connect is
+ *  the controller; the others may only use the commands marked for
+ *  any link.
+ *
+ *  Replies are queued per link and sent one at a time. AT+CIPSEND goes
+ *  out first, the data follows once the module's '>' prompt arrives,
+ *  and the slot is freed on SEND OK. A failure or timeout drops the
+ *  reply and counts it. Bytes bridged from the USB port are held from
+ *  AT+CIPSEND until the reply is finished.
+ *
+ *  IOT_USB_LINK is one more link for commands typed on the USB port
+ *  (usb_commands in commands.c). It is always open and its replies go
+ *  back out of the USB port through its TX queue, up to IOT_REPLY_DEPTH
+ *  of them at once.
+ *
+ *  Functions included:
+ *    - Init_Links: Closes every link and empties the reply queue.
+ *    - iot_link_rx: Drains iot_rx_ring through the +IPD parser.
+ *    - link_char: Builds module status lines and +IPD headers.
+ *    - link_line: Acts on one complete status line.
+ *    - iot_reply: Queues a reply to a link.
+ *    - iot_reply_process: Sends queued replies with AT+CIPSEND.
+ *    - reply_next: Frees the reply slot and lets the bridge go again.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "ringbuf.h"
+#include "iotlink.h"
+#include "latency.h"
+#include "swtimer.h"
+#include "bridge.h"
+
+// Parser states
+#define LINK_LINE       ('L')   // Reading a module status line
+#define LINK_PAYLOAD    ('P')   // Handing +IPD payload bytes to a link
+
+// Reply states
+#define REPLY_IDLE      ('I')
+#define REPLY_PROMPT    ('>')   // AT+CIPSEND sent, waiting for '>'
+#define REPLY_SENDING   ('S')   // Data sent, waiting for SEND OK
+
+extern ring_buf iot_rx_ring;
+
+iot_link iot_links[IOT_LINKS + 1];
+unsigned char iot_controller;
+
+char link_state;
+char link_line_buf[IOT_LINK_LINE];
+unsigned int link_line_len;
+unsigned char link_current;             // Link the payload belongs to
+unsigned int link_remaining;            // Payload bytes still to come
+unsigned int link_bad_header;           // +IPD headers that made no sense
+
+iot_reply_slot reply_queue[IOT_REPLY_DEPTH];
+unsigned int reply_head;
+unsigned int reply_tail;
+char reply_state;
+char reply_cipsend[24];                 // "AT+CIPSEND=<link>,<len>\r\n"
+volatile unsigned char reply_done;
+sw_timer iot_reply_timer;               // '>' or SEND OK timeout
+unsigned int reply_sent;
+unsigned int reply_failed;              // SEND FAIL, ERROR, timeout or full queue
+char usb_reply_buf[IOT_REPLY_DEPTH][IOT_REPLY_SIZE];  // Replies to IOT_USB_LINK going out
+volatile unsigned char usb_reply_done[IOT_REPLY_DEPTH];
+
+void link_char(char c);
+void link_line(void);
+void reply_next(void);
+
+void Init_Links(void){
+    unsigned int i;
+
+    for(i = 0; i <= IOT_USB_LINK; i++){
+        iot_links[i].open = FALSE;
+        iot_links[i].in_cmd = FALSE;
+        iot_links[i].cmd_len = 0;
+        iot_links[i].stamp = LAT_NONE;
+        iot_links[i].rx_bytes = 0;
+        iot_links[i].rejected = 0;
+    }
+    iot_links[IOT_USB_LINK].open = TRUE;   // The cable is always there
+    for(i = 0; i < IOT_REPLY_DEPTH; i++){
+        usb_reply_done[i] = TRUE;
+    }
+    iot_controller = IOT_NO_LINK;
+    link_state = LINK_LINE;
+    link_line_len = 0;
+    reply_head = 0;
+    reply_tail = 0;
+    reply_state = REPLY_IDLE;
+    reply_done = TRUE;
+}
+
+//-----------------------------------------------------------------
+// Payload bytes are passed on as slices of the ring; everything else
+// goes through link_char a byte at a time.
+//-----------------------------------------------------------------
+void iot_link_rx(void){
+    const char *data;
+    unsigned int length;
+    unsigned int i;
+
+    while((length = ring_peek(&iot_rx_ring, &data)) != 0){
+        if(link_state == LINK_PAYLOAD){
+            if(length > link_remaining){
+                length = link_remaining;
+            }
+            if(link_current < IOT_LINKS){
+                iot_links[link_current].rx_bytes += length;
+                iot_payload(link_current, data, length);
+            }
+            ring_consume(&iot_rx_ring, length);
+            link_remaining -= length;
+            if(!link_remaining){
+                link_state = LINK_LINE;
+            }
+            continue;
+        }
+        for(i = 0; i < length && link_state == LINK_LINE; i++){
+            link_char(data[i]);
+        }
+        ring_consume(&iot_rx_ring, i);
+    }
+}
+
+void link_char(char c){
+    unsigned int id;
+    unsigned int length;
+    const char *p;
+
+    if(c == '>' && !link_line_len && reply_state == REPLY_PROMPT){
+        reply_state = REPLY_SENDING;    // Prompt has no line end
+        reply_done = FALSE;
+        if(!iot_send(reply_queue[reply_tail].data, reply_queue[reply_tail].length, &reply_done)){
+            reply_done = TRUE;          // Nothing sent, SEND FAIL will follow
+        }
+        swt_start(&iot_reply_timer, MS_TO_TICKS(IOT_REPLY_TIMEOUT), SWT_ONE_SHOT);
+        return;
+    }
+    if(c == '\r' || (c == ' ' && !link_line_len)){
+        return;
+    }
+    if(c == '\n'){
+        link_line_buf[link_line_len] = 0;
+        if(link_line_len){
+            link_line();
+        }
+        link_line_len = 0;
+        return;
+    }
+    if(c == ':' && link_line_len > 5 && !strncmp(link_line_buf, "+IPD,", 5)){
+        link_line_buf[link_line_len] = 0;
+        link_line_len = 0;
+        id = 0;
+        length = 0;
+        p = &link_line_buf[5];
+        while(*p >= '0' && *p <= '9'){
+            id = id * 10 + (*p++ - '0');
+        }
+        if(*p++ == ','){
+            while(*p >= '0' && *p <= '9'){
+                length = length * 10 + (*p++ - '0');
+            }
+        }
+        if(!length){
+            link_bad_header++;
+            return;
+        }
+        if(id >= IOT_LINKS){
+            link_bad_header++;          // Still skip its payload
+        }
+        link_current = id < IOT_LINKS ? id : IOT_NO_LINK;
+        link_remaining = length;
+        link_state = LINK_PAYLOAD;
+        return;
+    }
+    if(link_line_len < sizeof(link_line_buf) - 1){
+        link_line_buf[link_line_len++] = c;
+    }
+}
+
+//-----------------------------------------------------------------
+// "<link>,CONNECT" and "<link>,CLOSED" open and close links. SEND OK,
+// SEND FAIL and ERROR finish the reply being sent.
+//-----------------------------------------------------------------
+void link_line(void){
+    unsigned char id;
+
+    if(link_line_buf[0] >= '0' && link_line_buf[0] < '0' + IOT_LINKS && link_line_buf[1] == ','){
+        id = link_line_buf[0] - '0';
+        if(!strcmp(&link_line_buf[2], "CONNECT")){
+            iot_links[id].open = TRUE;
+            iot_links[id].in_cmd = FALSE;
+            if(iot_controller == IOT_NO_LINK){
+                iot_controller = id;
+            }
+        } else if(!strncmp(&link_line_buf[2], "CLOSED", 6)){
+            iot_links[id].open = FALSE;
+            if(iot_controller == id){
+                iot_controller = IOT_NO_LINK;
+            }
+        }
+        return;
+    }
+    if(reply_state == REPLY_IDLE){
+        return;
+    }
+    if(!strcmp(link_line_buf, "SEND OK")){
+        reply_sent++;
+        reply_next();
+    } else if(!strcmp(link_line_buf, "SEND FAIL") || !strcmp(link_line_buf, "ERROR")){
+        reply_failed++;
+        reply_next();
+    }
+}
+
+//-----------------------------------------------------------------
+// Copies data into the reply queue. Returns FALSE, and counts it, if
+// the link is not open, the reply is too long or the queue is full.
+// A reply to IOT_USB_LINK goes straight to the USB TX queue instead,
+// from the first buffer that has been sent, so a command's reply and
+// its ack can follow each other.
+//-----------------------------------------------------------------
+char iot_reply(unsigned char link, const char *data, unsigned int length){
+    iot_reply_slot *slot;
+    unsigned int next = (reply_head + 1) & (IOT_REPLY_DEPTH - 1);
+    unsigned int i;
+
+    if(link == IOT_USB_LINK){
+        i = 0;
+        while(i < IOT_REPLY_DEPTH && !usb_reply_done[i]){
+            i++;                        // Still going out
+        }
+        if(i == IOT_REPLY_DEPTH || length > IOT_REPLY_SIZE || !length){
+            reply_failed++;
+            return FALSE;
+        }
+        memcpy(usb_reply_buf[i], data, length);
+        if(!usb_send(usb_reply_buf[i], length, &usb_reply_done[i])){
+            reply_failed++;
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if(link >= IOT_LINKS || !iot_links[link].open || length > IOT_REPLY_SIZE ||
+       !length || next == reply_tail){
+        reply_failed++;
+        return FALSE;
+    }
+    slot = &reply_queue[reply_head];
+    slot->link = link;
+    slot->length = length;
+    memcpy(slot->data, data, length);
+    reply_head = next;
+    return TRUE;
+}
+
+void iot_reply_process(void){
+    iot_reply_slot *slot;
+    char *p;
+
+    if(reply_state != REPLY_IDLE){
+        if(!swt_running(&iot_reply_timer) && reply_done){
+            reply_failed++;             // No '>' or SEND OK, give up on it
+            reply_next();
+        }
+        return;
+    }
+    if(reply_head == reply_tail || !reply_done){
+        return;                         // reply_cipsend still going out
+    }
+
+    slot = &reply_queue[reply_tail];
+    strcpy(reply_cipsend, "AT+CIPSEND=");
+    p = reply_cipsend + 11;
+    *p++ = '0' + slot->link;
+    *p++ = ',';
+    if(slot->length >= 10){
+        *p++ = '0' + slot->length / 10;
+    }
+    *p++ = '0' + slot->length % 10;
+    *p++ = '\r';
+    *p++ = '\n';
+
+    usb_to_iot.hold = TRUE;             // Before AT+CIPSEND can go out
+    reply_done = FALSE;
+    if(!iot_send(reply_cipsend, p - reply_cipsend, &reply_done)){
+        reply_done = TRUE;
+        usb_to_iot.hold = FALSE;
+        USCI_A0_transmit();
+        return;                         // TX queue full, try next pass
+    }
+    swt_start(&iot_reply_timer, MS_TO_TICKS(IOT_REPLY_TIMEOUT), SWT_ONE_SHOT);
+    reply_state = REPLY_PROMPT;
+}
+
+//-----------------------------------------------------------------
+// The reply is done with, sent or not. The TX interrupt went off
+// while the bridge was held, so it is turned back on for whatever
+// came in from the USB port meanwhile.
+//-----------------------------------------------------------------
+void reply_next(void){
+    reply_tail = (reply_tail + 1) & (IOT_REPLY_DEPTH - 1);
+    reply_state = REPLY_IDLE;
+    usb_to_iot.hold = FALSE;
+    USCI_A0_transmit();
+}
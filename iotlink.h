@@ -0,0 +1,47 @@
+/*
+ * iotlink.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  TCP links on the ESP32 server (AT+CIPMUX=1). Data from a client
+ *  arrives as "+IPD,<link>,<length>:<payload>" and replies go back with
+ *  AT+CIPSEND=<link>,<length>.
+ */
+
+#ifndef IOTLINK_H_
+#define IOTLINK_H_
+
+#define IOT_LINKS           (5)     // ESP32 allows link ids 0 to 4
+#define IOT_NO_LINK         (0xFF)
+#define IOT_USB_LINK        (IOT_LINKS)     // Commands typed on the USB port, see usb_commands()
+#define IOT_REPLY_DEPTH     (4)     // Must be a power of two
+#define IOT_REPLY_SIZE      (32)
+#define IOT_LINK_LINE       (24)    // Longest status line kept, "+IPD,4,2920:"
+#define IOT_REPLY_TIMEOUT   (1000)  // ms to wait for '>' or SEND OK
+
+typedef struct {
+    char open;                      // CONNECT seen, no CLOSED yet
+    char in_cmd;                    // Collecting a '^' command
+    char cmd[IOT_CMD_SIZE];
+    unsigned int cmd_len;
+    unsigned char stamp;            // Latency record for the command, LAT_NONE if none
+    unsigned int rx_bytes;          // Payload bytes received
+    unsigned int rejected;          // Commands refused, not the controller
+} iot_link;
+
+typedef struct {
+    unsigned char link;
+    unsigned char length;
+    char data[IOT_REPLY_SIZE];
+} iot_reply_slot;
+
+extern iot_link iot_links[IOT_LINKS + 1];   // Last one is IOT_USB_LINK
+extern unsigned char iot_controller;   // Link whose commands are run, or IOT_NO_LINK
+
+void Init_Links(void);
+void iot_link_rx(void);
+char iot_reply(unsigned char link, const char *data, unsigned int length);
+void iot_reply_process(void);
+
+#endif /* IOTLINK_H_ */
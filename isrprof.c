@@ -0,0 +1,112 @@
+/*
+ * isrprof.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file keeps the ISR profile. Each profiled ISR reads TB0R on
+ *  entry (ISR_PROF_ENTER) and calls isr_prof_exit on the way out, which
+ *  adds the run time and the time since the ISR's previous entry to
+ *  two histograms and keeps the worst run. isr_depth tells whether
+ *  another ISR was already running, which only happens if one of them
+ *  turns GIE back on. The tick ISR also records how late it started
+ *  after its compare value, which is the delay the other ISRs put on
+ *  it.
+ *
+ *  ^0000K4 sends one telemetry frame per ISR. Only two frames fit in
+ *  the USB buffers, so isr_prof_process sends them one at a time as
+ *  the buffers come free.
+ *
+ *  Everything here is left out unless ISR_PROFILE is 1.
+ *
+ *  Functions included:
+ *    - isr_prof_exit: ISR side, adds one run to the profile.
+ *    - isr_prof_bucket: Histogram bucket for a time.
+ *    - isr_prof_report: Starts sending the profile.
+ *    - isr_prof_process: Sends the next ISR's frame when there is room.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "isrprof.h"
+#include "telemetry.h"
+#include "timebase.h"
+
+#if ISR_PROFILE
+isr_prof isr_profs[ISR_PROF_COUNT];
+unsigned char isr_depth;
+unsigned char isr_prof_next = ISR_PROF_COUNT;   // Next ISR to dump
+
+static unsigned int isr_prof_bucket(unsigned long us, unsigned char shift){
+    us >>= shift;
+    return us < ISR_PROF_BUCKETS ? (unsigned int)us : ISR_PROF_BUCKETS - 1;
+}
+
+//-----------------------------------------------------------------
+// Runs with interrupts off, inside the ISR. now_us() gives the
+// entry time in full from the TB0R read at entry.
+//-----------------------------------------------------------------
+void isr_prof_exit(unsigned char id, unsigned int start){
+    isr_prof *prof = &isr_profs[id];
+    unsigned long now = now_us();
+    unsigned int duration = (unsigned int)now - start;
+    unsigned long entry = now - duration;
+
+    if(prof->count){
+        prof->interval[isr_prof_bucket(TIME_SINCE(entry, prof->last), ISR_PROF_GAP_SHIFT)]++;
+    }
+    prof->last = entry;
+    prof->duration[isr_prof_bucket(duration, ISR_PROF_DUR_SHIFT)]++;
+    prof->count++;
+    if(duration > prof->worst){
+        prof->worst = duration;
+    }
+    if(isr_depth > 1){
+        prof->nested++;
+    }
+    isr_depth--;
+}
+
+void isr_prof_report(void){
+    isr_prof_next = 0;
+}
+
+void isr_prof_process(void){
+    unsigned char payload[TLM_ISR_LEN];
+    isr_prof prof;
+    unsigned int i;
+
+    if(isr_prof_next >= ISR_PROF_COUNT || !telemetry_ready()){
+        return;
+    }
+    __disable_interrupt();              // Copy it whole
+    prof = isr_profs[isr_prof_next];
+    __enable_interrupt();
+
+    payload[TLM_IS_ID] = isr_prof_next;
+    payload[TLM_IS_ID + 1] = 0;
+    put_u16(&payload[TLM_IS_COUNT], prof.count);
+    put_u16(&payload[TLM_IS_WORST], prof.worst);
+    put_u16(&payload[TLM_IS_NESTED], prof.nested);
+    put_u16(&payload[TLM_IS_LATE], prof.late);
+    for(i = 0; i < ISR_PROF_BUCKETS; i++){
+        put_u16(&payload[TLM_IS_DURATION + 2 * i], prof.duration[i]);
+        put_u16(&payload[TLM_IS_INTERVAL + 2 * i], prof.interval[i]);
+    }
+    if(telemetry_send(TLM_TYPE_ISR, payload, TLM_ISR_LEN)){
+        isr_prof_next++;
+    }
+}
+#else
+void isr_prof_report(void){
+}
+
+void isr_prof_process(void){
+}
+#endif
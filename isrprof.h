@@ -0,0 +1,69 @@
+/*
+ * isrprof.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  ISR profiler. Built in when ISR_PROFILE (macros.h) is 1, otherwise
+ *  the macros below are empty and the ISRs are unchanged. Include after
+ *  msp430.h and macros.h.
+ */
+
+#ifndef ISRPROF_H_
+#define ISRPROF_H_
+
+// ISRs profiled, also the order of the dump
+#define ISR_PROF_UCA0       (0)     // eUSCI_A0_ISR, IOT
+#define ISR_PROF_UCA1       (1)     // eUSCI_A1_ISR, USB
+#define ISR_PROF_TB0_0      (2)     // Timer0_B0_ISR, tick
+#define ISR_PROF_TB0_1      (3)     // TIMER0_B1_ISR, debounce and overflow
+#define ISR_PROF_ADC        (4)     // ADC_ISR
+#define ISR_PROF_PORT2      (5)     // switchP2_interrupt
+#define ISR_PROF_PORT4      (6)     // switchP4_interrupt
+#define ISR_PROF_COUNT      (7)
+#define ISR_PROF_BUCKETS    (16)
+#define ISR_PROF_DUR_SHIFT  (3)     // Duration buckets are 8 us wide
+#define ISR_PROF_GAP_SHIFT  (10)    // Inter-arrival buckets are 1.024 ms wide
+
+typedef struct {
+    unsigned int count;
+    unsigned int worst;             // Longest run, us
+    unsigned int nested;            // Entered while another ISR was running
+    unsigned int late;              // Timer ISRs, worst start after the compare, us
+    unsigned long last;             // now_us() of the last entry
+    unsigned int duration[ISR_PROF_BUCKETS];
+    unsigned int interval[ISR_PROF_BUCKETS];
+} isr_prof;
+
+#if ISR_PROFILE
+extern isr_prof isr_profs[ISR_PROF_COUNT];
+extern unsigned char isr_depth;
+
+// First statement after the ISR's declarations
+#define ISR_PROF_ENTER(id)                                  \
+    unsigned int isr_prof_start = TB0R;                     \
+    isr_depth++
+
+// Timer ISRs: how long after the compare value the ISR started
+#define ISR_PROF_LATE(id, compare)                          \
+    do {                                                    \
+        unsigned int isr_prof_late = isr_prof_start - (compare); \
+        if(isr_prof_late > isr_profs[id].late){             \
+            isr_profs[id].late = isr_prof_late;             \
+        }                                                   \
+    } while(0)
+
+// Last statement of the ISR
+#define ISR_PROF_EXIT(id)   isr_prof_exit((id), isr_prof_start)
+
+void isr_prof_exit(unsigned char id, unsigned int start);
+#else
+#define ISR_PROF_ENTER(id)
+#define ISR_PROF_LATE(id, compare)
+#define ISR_PROF_EXIT(id)
+#endif
+
+void isr_prof_report(void);
+void isr_prof_process(void);
+
+#endif /* ISRPROF_H_ */
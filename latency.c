@@ -0,0 +1,255 @@
+/*
+ * latency.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file measures how long an IOT command takes to go from the
+ *  UART to the motors. The IOT RX ISR stamps every '^' with the ring
+ *  position it was stored at. When the tokenizer reaches that byte it
+ *  claims the stamp, the command is stamped again once it has been
+ *  parsed, and once more when it is applied. For a move that is the
+ *  pass of movement_machine that first sets TB3 for it, so time spent
+ *  waiting in the motion queue is included. The delays go back to the
+ *  sender as "A <op> <parse us> <total us>" and are kept as
+ *  min/avg/max and a histogram for percentiles.
+ *
+ *  Stamps are now_us() values, so every delay is timed to the
+ *  microsecond however long it is.
+ *
+ *  Functions included:
+ *    - Init_Latency: Clears the stamps and statistics.
+ *    - lat_rx_isr: RX ISR side, stamps a '^'.
+ *    - lat_begin: Claims the RX stamp for a '^' at a ring position.
+ *    - lat_decimal: Writes a number for the ack.
+ *    - lat_parsed: Stamps a parsed command.
+ *    - lat_applied: Stamps an applied command and sends the ack.
+ *    - lat_add: Adds one delay to a set of statistics.
+ *    - lat_percentile: Reads a percentile from the histogram.
+ *    - lat_report: Sends the statistics as a telemetry frame.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "latency.h"
+#include "iotlink.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "motion.h"
+
+// A record is reused LAT_RECORDS commands later. Every queued move
+// plus the one being parsed must still own its record when it runs.
+#if LAT_RECORDS & (LAT_RECORDS - 1)
+#error "LAT_RECORDS must be a power of two"
+#endif
+#if LAT_RECORDS <= MOTION_QUEUE_DEPTH
+#error "LAT_RECORDS must be more than MOTION_QUEUE_DEPTH"
+#endif
+
+
+typedef struct {
+    unsigned int pos;               // iot_rx_ring position of the '^'
+    unsigned long stamp;            // now_us()
+} lat_rx_entry;
+
+lat_rx_entry lat_rx_fifo[LAT_RX_DEPTH];
+volatile unsigned int lat_rx_head;      // Written by the RX ISR only
+unsigned int lat_rx_tail;
+volatile unsigned int lat_rx_lost;      // '^' not stamped, FIFO full
+
+lat_record lat_records[LAT_RECORDS];
+unsigned char lat_next;
+lat_stats lat_total;
+lat_stats lat_parse;
+char lat_ack;
+
+void lat_add(lat_stats *stats, unsigned long us);
+
+void Init_Latency(void){
+    unsigned int i;
+
+    for(i = 0; i < LAT_RECORDS; i++){
+        lat_records[i].link = IOT_NO_LINK;
+    }
+    lat_rx_head = 0;
+    lat_rx_tail = 0;
+    lat_rx_lost = 0;
+    lat_next = 0;
+    memset(&lat_total, 0, sizeof(lat_total));
+    memset(&lat_parse, 0, sizeof(lat_parse));
+    lat_total.min_us = 0xFFFFFFFF;
+    lat_parse.min_us = 0xFFFFFFFF;
+    lat_ack = LAT_ACK_ON;
+}
+
+//-----------------------------------------------------------------
+// Called from eUSCI_A0_ISR with the ring position the '^' went to.
+//-----------------------------------------------------------------
+void lat_rx_isr(unsigned int pos){
+    unsigned int head = lat_rx_head;
+    lat_rx_entry *entry;
+
+    if(head - lat_rx_tail >= LAT_RX_DEPTH){
+        lat_rx_lost++;
+        return;
+    }
+    entry = &lat_rx_fifo[head & (LAT_RX_DEPTH - 1)];
+    entry->pos = pos;
+    entry->stamp = now_us();
+    lat_rx_head = head + 1;
+}
+
+//-----------------------------------------------------------------
+// Stamps are claimed in ring order; older ones belonged to a '^'
+// that was not in a +IPD payload and are thrown away.
+//-----------------------------------------------------------------
+unsigned char lat_begin(unsigned int pos){
+    lat_rx_entry *entry;
+    lat_record *record;
+    unsigned char id;
+
+    while(lat_rx_tail != lat_rx_head){
+        entry = &lat_rx_fifo[lat_rx_tail & (LAT_RX_DEPTH - 1)];
+        if((int)(entry->pos - pos) > 0){
+            return LAT_NONE;            // This '^' was not stamped
+        }
+        lat_rx_tail++;
+        if(entry->pos == pos){
+            id = lat_next++ & (LAT_RECORDS - 1);
+            record = &lat_records[id];
+            record->rx = entry->stamp;
+            record->link = IOT_NO_LINK;
+            return id;
+        }
+    }
+    return LAT_NONE;
+}
+
+void lat_parsed(unsigned char id, unsigned char link, char opcode){
+    lat_record *record;
+
+    if(id == LAT_NONE){
+        return;
+    }
+    record = &lat_records[id];
+    record->parsed = now_us();
+    record->link = link;
+    record->opcode = opcode;
+    lat_add(&lat_parse, TIME_SINCE(record->parsed, record->rx));
+}
+
+// Writes value in decimal, returns the number of digits
+static char lat_decimal(char *dest, unsigned long value){
+    char digits[10];
+    char n = 0;
+    char len = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    while(n){
+        dest[len++] = digits[--n];
+    }
+    return len;
+}
+
+void lat_applied(unsigned char id){
+    lat_record *record;
+    unsigned long now;
+    unsigned long parse_us;
+    unsigned long total_us;
+    char ack[IOT_REPLY_SIZE];
+    char len = 0;
+
+    if(id == LAT_NONE){
+        return;
+    }
+    record = &lat_records[id];
+    if(record->link == IOT_NO_LINK){
+        return;                         // Slot reused, or never parsed
+    }
+    now = now_us();
+    parse_us = TIME_SINCE(record->parsed, record->rx);
+    total_us = TIME_SINCE(now, record->rx);
+    lat_add(&lat_total, total_us);
+
+    if(lat_ack == LAT_ACK_ON){
+        ack[len++] = 'A';
+        ack[len++] = ' ';
+        ack[len++] = record->opcode;
+        ack[len++] = ' ';
+        len += lat_decimal(&ack[len], parse_us);
+        ack[len++] = ' ';
+        len += lat_decimal(&ack[len], total_us);
+        ack[len++] = '\r';
+        ack[len++] = '\n';
+        iot_reply(record->link, ack, len);
+    }
+    record->link = IOT_NO_LINK;
+}
+
+void lat_add(lat_stats *stats, unsigned long us){
+    unsigned long v = us;
+    unsigned int k = 0;
+
+    while(v >= LAT_BUCKET0_US && k < LAT_BUCKETS - 1){
+        v >>= 1;
+        k++;
+    }
+    stats->bucket[k]++;
+    stats->count++;
+    stats->sum_us += us;
+    if(us < stats->min_us){
+        stats->min_us = us;
+    }
+    if(us > stats->max_us){
+        stats->max_us = us;
+    }
+}
+
+//-----------------------------------------------------------------
+// Upper edge of the histogram bucket the percentile falls in.
+//-----------------------------------------------------------------
+unsigned long lat_percentile(const lat_stats *stats, unsigned int percent){
+    unsigned long target;
+    unsigned long seen = 0;
+    unsigned int k;
+
+    if(!stats->count){
+        return 0;
+    }
+    target = ((unsigned long)stats->count * percent + 99) / 100;
+    for(k = 0; k < LAT_BUCKETS - 1; k++){
+        seen += stats->bucket[k];
+        if(seen >= target){
+            return (unsigned long)LAT_BUCKET0_US << k;
+        }
+    }
+    return stats->max_us;
+}
+
+static void lat_put_set(unsigned char *dest, const lat_stats *stats){
+    put_u16(&dest[TLM_LS_COUNT], stats->count);
+    put_u32(&dest[TLM_LS_MIN], stats->count ? stats->min_us : 0);
+    put_u32(&dest[TLM_LS_AVG], stats->count ? stats->sum_us / stats->count : 0);
+    put_u32(&dest[TLM_LS_MAX], stats->max_us);
+    put_u32(&dest[TLM_LS_P50], lat_percentile(stats, 50));
+    put_u32(&dest[TLM_LS_P95], lat_percentile(stats, 95));
+    put_u32(&dest[TLM_LS_P99], lat_percentile(stats, 99));
+}
+
+void lat_report(void){
+    unsigned char payload[TLM_LATENCY_LEN];
+
+    lat_put_set(&payload[TLM_LAT_TOTAL], &lat_total);
+    lat_put_set(&payload[TLM_LAT_PARSE], &lat_parse);
+    put_u16(&payload[TLM_LAT_LOST], lat_rx_lost);
+    telemetry_send(TLM_TYPE_LATENCY, payload, TLM_LATENCY_LEN);
+}
@@ -0,0 +1,55 @@
+/*
+ * latency.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Command latency stamps. Each IOT command is stamped when its '^'
+ *  arrives in the UART ISR, when it has been parsed and when it is
+ *  applied (the first TB3 write for a move).
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#define LAT_RX_DEPTH        (8)     // '^' stamps waiting for the parser, power of two
+#define LAT_RECORDS         (16)    // Commands in flight, power of two
+#define LAT_NONE            (0xFF)
+#define LAT_BUCKETS         (16)
+#define LAT_BUCKET0_US      (64)    // Bucket 0 is below this, each next doubles
+
+// ^0000K<n>
+#define LAT_ACK_OFF         (0)
+#define LAT_ACK_ON          (1)
+#define LAT_DUMP            (2)
+#define LAT_TASKS           (3)     // Scheduler statistics, see scheduler.c
+#define LAT_ISRS            (4)     // ISR profile, see isrprof.c
+
+typedef struct {
+    unsigned long rx;               // now_us()
+    unsigned long parsed;
+    unsigned char link;
+    char opcode;
+} lat_record;
+
+typedef struct {
+    unsigned int count;
+    unsigned long min_us;
+    unsigned long max_us;
+    unsigned long sum_us;
+    unsigned int bucket[LAT_BUCKETS];
+} lat_stats;
+
+extern lat_stats lat_total;         // RX to applied
+extern lat_stats lat_parse;         // RX to parsed
+extern char lat_ack;
+
+void Init_Latency(void);
+void lat_rx_isr(unsigned int pos);
+unsigned char lat_begin(unsigned int pos);
+void lat_parsed(unsigned char id, unsigned char link, char opcode);
+void lat_applied(unsigned char id);
+unsigned long lat_percentile(const lat_stats *stats, unsigned int percent);
+void lat_report(void);
+
+#endif /* LATENCY_H_ */
@@ -24,6 +24,7 @@
 #define GRN_LED              (0x40) // GREEN LED 1
 #define TEST_PROBE           (0x01) // 0 TEST PROBE
 #define TRUE                 (0x01) //
+#define FALSE                (0x00) //
 
 #define P4PUD (P4OUT)
 
@@ -39,13 +40,16 @@
 #define RUN ('R')
 #define END ('E')
 
-#define SSID ('S')
-#define IP ('I')
-#define SERVER ('E')
-#define MUX ('M')
-#define STORE ('T')
-#define WAITSSID ('D')
-#define WAITIP ('P')
+// IOT boot sequence
+#define IOT_RESET ('R')     // Holding the ESP32 in reset
+#define IOT_SEND ('S')      // Sending the current step's command
+#define IOT_WAIT ('W')      // Waiting for the step's reply
+#define IOT_RETRY ('Y')     // Waiting to resend after ERROR or a timeout
+#define IOT_READY ('D')     // Boot finished, commands accepted
+#define IOT_FAILED ('F')    // Gave up, commands accepted anyway
+#define IOT_EN_DELAY (150)      // ms after reset before IOT_EN is raised
+#define IOT_RETRY_DELAY (200)   // ms between a failed step and its resend
+#define COURSE_STEP_MS (100)    // ms per count of the course timer
 
 #define FORWARD ('F')
 #define BACKWARD ('B')
@@ -54,6 +58,9 @@
 #define STOP ('S')
 #define BLACKLINE ('C')
 #define BUMP ('P')
+#define MOVE_STRAIGHT_MS (250)  // ms per digit of ^....F<n> and B<n>
+#define MOVE_TURN_MS (200)      // ms per digit of ^....R<n> and L<n>
+#define MOVE_BUMP_MS (50)       // ms per digit of ^....P<n>
 
 #define WHEEL_COUNT_TIME (20)
 
@@ -93,14 +100,21 @@
 #define NOT_OKAY (0)
 #define OKAY (1)
 #define DEBOUNCE_RESTART (0)
-#define SW1DEBOUNCE (50000)
-#define SW2DEBOUNCE (50000)
+#define SW1DEBOUNCE (60000)    // us, TB0 counts 1 MHz
+#define SW2DEBOUNCE (60000)
+
+// Clocks
+#define MCLK_FREQ_MHZ           (8) // MCLK = 8MHz
+#define SMCLK_FREQ (MCLK_FREQ_MHZ * 1000000UL) // SMCLK = MCLK
 
 // Timers
+#ifndef TICK_MS
+#define TICK_MS (10)            // System tick, 1 to 65 ms, see timebase.h
+#endif
+#define MS_TO_TICKS(ms) (((ms) + TICK_MS - 1) / TICK_MS)   // Rounded up
 
-#define TB0CCR0_INTERVAL (5000)
-#define TB0CCR1_INTERVAL (50000)
-#define TB0CCR2_INTERVAL (50000)
+#define TB0CCR1_INTERVAL (60000)
+#define TB0CCR2_INTERVAL (60000)
 
 //Project 6
 #define PROJ6 ('6')
@@ -116,6 +130,7 @@
 #define RIGHT_WHEEL_SLOW (8000)
 #define PERCENT_100 (50000)
 #define PERCENT_80 (45000)
+#define PWM_PER_PERCENT (500u)  // WHEEL_PERIOD / 100
 
 #define BEGINNING (0x00)
 
@@ -134,6 +149,25 @@
 #define LEFTTRAVEL ('!')
 #define RIGHTTRAVEL ('Z')
 
+// Serial
+#define IOT_RX_SIZE (256)   // Ring sizes must be a power of two
+#define USB_RX_SIZE (128)
+#define IOT_CMD_SIZE (20)       // Longest '^' command plus NULL
+#define CMD_KEY "0000"          // Every IOT command starts with this
+#define IOT_BAUD (BAUD_115200)  // Rate the ESP32 starts up at
+#define USB_BAUD (BAUD_115200)
+#define BAUD_NONE (BAUD_COUNT)  // No rate change waiting
+#define IOT_BAUD_SETTLE (50)    // ms for the ESP32's OK to finish at the old rate
+
+// Telemetry
+#define TELEMETRY_PERIOD (0)    // ms between status frames, 0 = off at power up
+#define TELEMETRY_STEP (100)    // ms per digit of the ^....T<n> command
+
+// Build options
+#ifndef ISR_PROFILE
+#define ISR_PROFILE (0)         // 1 = time every ISR, see isrprof.c
+#endif
+
 
 
 #endif /* MACROS_H_ */
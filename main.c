@@ -8,11 +8,13 @@
  *  ------------
  *  This file contains the main routine ("while" operating system) for the
  *  MSP430 system. It initializes peripherals, clears the display, and
- *  manages the main control flow using state machines, periodic updates,
- *  and IOT command handling.
+ *  hands the main control flow to the task scheduler in scheduler.c,
+ *  which runs the state machines, periodic updates and IOT command
+ *  handling. Between passes the CPU sleeps (power.c).
  *
  *  Functions included:
  *    - main: Initializes the system and runs the main control loop.
+ *    - Seconds_Process: Counts and shows the course time.
  *
  */
 
@@ -23,6 +25,12 @@
 #include "LCD.h"
 #include "ports.h"
 #include "macros.h"
+#include "iotlink.h"
+#include "latency.h"
+#include "scheduler.h"
+#include "power.h"
+#include "swtimer.h"
+#include "timebase.h"
 
 // Function Prototypes
 void main(void);
@@ -56,8 +64,6 @@ unsigned int IR;
 extern volatile unsigned int time_change;
 extern volatile unsigned int instruction;
 extern volatile unsigned int Backlite;
-extern volatile unsigned int count_debounce_SW1;
-extern volatile unsigned int count_debounce_SW2;
 extern volatile unsigned int sw1_position;
 extern volatile unsigned int sw2_position;
 extern unsigned int ADC_Channel;
@@ -68,49 +74,29 @@ extern unsigned int p6;
 volatile unsigned int proj7timer;
 volatile unsigned int proj7timer2;
 volatile unsigned int proj7timerdisplay;
-unsigned int calibration;
-unsigned int avg;
 
-volatile unsigned int proj8timer;
-volatile unsigned int proj8display;
 char NCSUArray [9];
-extern char usb_tx_buf [160];
-extern char usb_rx_buf [160];
 char process_buf [11];
-extern unsigned int usb_tx;
-extern unsigned int usb_rx;
 unsigned int transmit;
 
 
-extern unsigned int iot_tx;
-extern unsigned int iot_rx;
-extern char iot_rx_buf [160];
-extern char iot_tx_buf [160];
 unsigned int process_buf_ptr;
-unsigned int read_ptr;
 
 unsigned int clear_usb_rx;
 unsigned int clear_iot_rx;
 unsigned int clear_process;
 
-unsigned int iot_boot_timer;
 unsigned int cmdFram;
 unsigned int iot_init_cmd;
 
-extern unsigned int ssid_ptr;
-extern unsigned int ip_ptr;
 
-extern char iotState;
-extern unsigned int bigCmd_ptr;
-extern unsigned int smCmd_ptr;
-extern unsigned int startCaret;
-
-char movement;
-unsigned int timeLength;
+extern char movement;
+extern unsigned int timeLength;
 extern unsigned int padNum;
 
-extern volatile unsigned int tenmsCounter;
 unsigned int secondsCounter;
+sw_timer seconds_timer;                 // Display refresh for the course timer
+unsigned long course_start;             // now_ms() when the course timer started
 unsigned int timer_start;
 
 extern unsigned int BLStart;
@@ -127,6 +113,7 @@ void main(void) {
     Init_LCD();
     Init_ADC();
     Init_Serial();
+    Init_Telemetry();
 
 
     // Clear Display
@@ -136,55 +123,50 @@ void main(void) {
     strcpy(display_line[3], "          ");
     display_changed = TRUE;
     state = WAIT;
-    proj8timer = 0;
     UCA0IE |= UCRXIE;
-    read_ptr = 0;
     transmit = 0;
 
-    iot_boot_timer = 0;
-    iotState = STORE;
-    ssid_ptr = 0;
-    ip_ptr = 0;
-    bigCmd_ptr = 0;
-    smCmd_ptr = 0;
-    startCaret = 0;
+    Init_IOT();
+    Init_Links();
+    Init_Latency();
+    Init_Calibration();
+    Init_Battery();
+    Init_Edge();
     movement = NONE;
     timeLength = 0;
     padNum = 0;
     timer_start = 0;
-    tenmsCounter = 0;
     secondsCounter = 0;
     BLStart = 0;
 
+    Init_Scheduler();
+    Init_Power();
+
     // Main Loop
     while(ALWAYS) {                      // Can the Operating system runs
-
-        bootIOT();
-        movement_machine();
-
-        if(!timer_start){
-            tenmsCounter = 0;
-        } else {
-            if(tenmsCounter > 9){
-                secondsCounter++;
-                tenmsCounter = 0;
-
-                HEXtoBCD(secondsCounter);
-                adc_line(4,6);
-                display_line[3][9] = 's';
-                display_changed = TRUE;
-            }
-        }
-
-
-
-
-        if(iot_boot_timer >= 15){
-            P3OUT |= IOT_EN;
-            P3OUT |= IOT_LINK_GRN;
-        }
-
-        Display_Process();                 // Update Display
+        Scheduler_Run();                   // Tasks are listed in scheduler.c
         P3OUT ^= TEST_PROBE;               // Change State of TEST_PROBE OFF
+        Idle_Process();                    // LPM0 until an ISR has work
     }
   }
+
+//-----------------------------------------------------------------
+// Course timer shown on the bottom line, run every tick
+//-----------------------------------------------------------------
+void Seconds_Process(void){
+    if(!timer_start){
+        return;
+    }
+    if(!swt_running(&seconds_timer)){
+        course_start = now_ms();
+        swt_start(&seconds_timer, MS_TO_TICKS(COURSE_STEP_MS), MS_TO_TICKS(COURSE_STEP_MS));
+    }
+    if(swt_fired(&seconds_timer)){
+        secondsCounter = MS_SINCE(course_start) / COURSE_STEP_MS;
+
+        HEXtoBCD(secondsCounter);
+        adc_line(4,6);
+        display_line[3][9] = 's';
+        display_changed = TRUE;
+    }
+}
@@ -0,0 +1,192 @@
+/*
+ * motion.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file contains the motion queue and the movement state machine.
+ *  Timed moves from the IOT commands are appended to a FIFO and run one
+ *  after the other. When a move's time runs out the next one is started
+ *  in the same pass, so the motors are only turned off when the queue
+ *  is empty. A full queue refuses the move and counts it. A move can
+ *  carry its own duty cycle, otherwise the usual speeds are used.
+ *
+ *  A line course (BLACKLINE) arms the ADC_ISR brake in edge.c. Any way
+ *  out of the course, a flush, a replace or the next queued move,
+ *  disarms it, so it cannot stop a later move or leave a stale brake
+ *  for the next course.
+ *
+ *  Functions included:
+ *    - motion_append: Adds a move to the end of the queue.
+ *    - motion_replace: Throws away queued moves and starts this one now.
+ *    - motion_flush: Empties the queue and stops the motors right away.
+ *    - motion_pending: Returns the number of queued moves.
+ *    - motion_next: Starts the oldest queued move.
+ *    - movement_machine: Drives the motors for the current move.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "LCD.h"
+#include "ports.h"
+#include "macros.h"
+#include "motion.h"
+#include "latency.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "adc.h"
+#include "edge.h"
+
+#define MOTION_QUEUE_MASK (MOTION_QUEUE_DEPTH - 1)
+
+extern char BLState;
+extern unsigned int BLStart;
+
+char movement;                          // Current move, NONE when idle
+unsigned int timeLength;                // Ticks the current move lasts
+sw_timer motion_timer;                  // Runs out when the current move is done
+unsigned char speed;                    // Percent duty, 0 = usual speeds
+unsigned char motion_stamp = LAT_NONE;  // Latency record of the move just started
+
+motion_step motion_queue[MOTION_QUEUE_DEPTH];
+unsigned int motion_head;               // Next free entry
+unsigned int motion_tail;               // Oldest entry
+unsigned int motion_overflow;           // Moves refused, queue full
+
+char motion_next(void);
+
+char motion_append(char move, unsigned int duration, unsigned char duty,
+                   unsigned char stamp){
+    motion_step *step;
+
+    if(motion_head - motion_tail >= MOTION_QUEUE_DEPTH){
+        motion_overflow++;
+        return FALSE;
+    }
+    step = &motion_queue[motion_head & MOTION_QUEUE_MASK];
+    step->movement = move;
+    step->duration = duration;
+    step->speed = duty;
+    step->stamp = stamp;
+    motion_head++;
+    return TRUE;
+}
+
+char motion_replace(char move, unsigned int duration, unsigned char duty,
+                    unsigned char stamp){
+    motion_tail = motion_head;
+    motion_append(move, duration, duty, stamp);
+    return motion_next();
+}
+
+void motion_flush(void){
+    motion_tail = motion_head;
+    edge_disarm();                      // No brake left over from a course
+    turn_off_motors();
+    movement = NONE;
+    speed = 0;
+    motion_stamp = LAT_NONE;
+    swt_cancel(&motion_timer);
+}
+
+unsigned int motion_pending(void){
+    return motion_head - motion_tail;
+}
+
+char motion_next(void){
+    motion_step *step;
+
+    if(motion_head == motion_tail){
+        return FALSE;
+    }
+    step = &motion_queue[motion_tail & MOTION_QUEUE_MASK];
+    if(movement == BLACKLINE){
+        edge_disarm();                  // Leaving the course, its brake goes too
+    }
+    movement = step->movement;
+    timeLength = step->duration;
+    speed = step->speed;
+    motion_stamp = step->stamp;
+    swt_start(&motion_timer, timeLength + 1, SWT_ONE_SHOT);
+    motion_tail++;
+    return TRUE;
+}
+
+//-----------------------------------------------------------------
+// Runs every pass of the main loop. An idle machine, or a move that
+// has used up its time, pulls the next queued move before the motors
+// are set, so back to back moves have no stop in between.
+//-----------------------------------------------------------------
+void movement_machine(void){
+    switch(movement){
+        case FORWARD:
+        case BACKWARD:
+        case LEFT:
+        case RIGHT:
+        case BUMP:
+            if(!swt_running(&motion_timer) && !motion_next()){
+                turn_off_motors();
+                movement = NONE;
+            }
+            break;
+        case BLACKLINE:
+            if(BLStart && BLState == NONE){
+                motion_next();          // Course finished, carry on with the queue
+            }
+            break;
+        case STOP:
+            turn_off_motors();
+            movement = NONE;
+            // fall through
+        default:
+            motion_next();
+            break;
+    }
+
+    switch(movement){
+        case FORWARD:
+            if(speed){
+                set_motor_speeds(speed, speed);
+            } else {
+                forward_fast();
+            }
+            break;
+        case BACKWARD:
+            if(speed){
+                set_motor_speeds(-(int)speed, -(int)speed);
+            } else {
+                reverse_fast();
+            }
+            break;
+        case LEFT:
+            if(speed){
+                set_motor_speeds(speed, 0);
+            } else {
+                turn_right();
+            }
+            break;
+        case RIGHT:
+        case BUMP:
+            if(speed){
+                set_motor_speeds(0, speed);
+            } else {
+                turn_left();
+            }
+            break;
+        case BLACKLINE:
+            BlackLineIntercept();
+            break;
+        default:
+            break;
+    }
+
+    if(motion_stamp != LAT_NONE){
+        lat_applied(motion_stamp);      // TB3 now set for the new move
+        motion_stamp = LAT_NONE;
+    }
+}
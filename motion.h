@@ -0,0 +1,31 @@
+/*
+ * motion.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Queue of timed moves carried out by movement_machine.
+ */
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#define MOTION_QUEUE_DEPTH (8)  // Must be a power of two
+
+typedef struct {
+    char movement;              // FORWARD, BACKWARD, LEFT, RIGHT, BUMP, BLACKLINE
+    unsigned int duration;      // Ticks, ignored for BLACKLINE
+    unsigned char speed;        // Percent duty, 0 = the move's usual speeds
+    unsigned char stamp;        // Latency record, stamped when the move starts
+} motion_step;
+
+extern unsigned int motion_overflow;
+
+char motion_append(char movement, unsigned int duration, unsigned char speed,
+                   unsigned char stamp);
+char motion_replace(char movement, unsigned int duration, unsigned char speed,
+                    unsigned char stamp);
+void motion_flush(void);
+unsigned int motion_pending(void);
+
+#endif /* MOTION_H_ */
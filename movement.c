@@ -23,6 +23,10 @@
 #include  "LCD.h"
 #include  "ports.h"
 #include "macros.h"
+#include "timebase.h"
+#include "adc.h"
+#include "calibrate.h"
+#include "edge.h"
 
 extern char display_line[4][11];
 extern char display_changed;
@@ -30,10 +34,6 @@ extern volatile unsigned char update_display;
 
 extern unsigned int sw1_position;
 extern unsigned int sw2_position;
-unsigned int calibration;
-unsigned int Wcal;
-unsigned int Bcal;
-unsigned int avg;
 
 
 unsigned int BLStart;
@@ -41,7 +41,6 @@ char BLState;
 
 extern volatile unsigned int proj7timerDisplay;
 extern volatile unsigned int proj7timer;
-extern volatile unsigned int timer10s;
 
 extern unsigned int secondsCounter;
 extern unsigned int timer_start;
@@ -49,38 +48,63 @@ unsigned int ADC_Channel;
 unsigned int ADC_Left_Det;
 unsigned int ADC_Right_Det;
 unsigned int ADC_Thumb;
-volatile unsigned int wait;
+unsigned long bl_state_start;           // now_ms() when the line state began
+unsigned long bl_move_start;            // now_ms() when the current turn or run began
+char bl_left_black;                     // Detectors over the line, see cal_black()
+char bl_right_black;
 
 //-----------------------------------------------------------------
 // State Machine for Black Line Intercept
 // Follows instructions for intercepting the black line from pad 8
 // Updates display following instructions from Project 10
+// The detectors are read once per call from the ADC snapshot and
+// tested against the calibrated thresholds (calibrate.c). Where the
+// car has to stop on the line, edge.c is armed so ADC_ISR stops it
+// on the crossing; the polled test is still there behind it.
 //
 //-----------------------------------------------------------------
 void BlackLineIntercept(void){
+    adc_snapshot snap;
+    char left;
+    char right;
+
+    adc_read(&snap);                    // Left and right from the same pass
+    bl_left_black = cal_black(ADC_LEFT, snap.value[ADC_LEFT], bl_left_black);
+    bl_right_black = cal_black(ADC_RIGHT, snap.value[ADC_RIGHT], bl_right_black);
+    left = bl_left_black;
+    right = bl_right_black;
+
+    if(BLState != START && BLState != TURN){
+        edge_disarm();                  // Only those two stop on the line
+    }
+
     if(!BLStart){
         BLStart++;
         BLState = START;
-        timer10s = 0;
+        bl_state_start = now_ms();
     }
 
     switch(BLState){
         case START:
-            if(timer10s < 600){
+            if(MS_SINCE(bl_state_start) < 6000){
                 P6OUT  |= LCD_BACKLITE;
                 strcpy(display_line[0], " BL START ");
                 display_changed = TRUE;
-                wait = 0;
+                bl_move_start = now_ms();
             } else {
                 P6OUT  &= ~LCD_BACKLITE;
-                if(wait <= 48){         // 41 = 90 deg
+                if(MS_SINCE(bl_move_start) <= 480){         // 410 = 90 deg
                     spin_counterclockwise();
                 } else {
-                    forward_fast();
-                    if(wait >= 350 && (ADC_Left_Det > 600 || ADC_Right_Det > 600)){
+                    if(MS_SINCE(bl_move_start) >= 3500){
+                        edge_arm(EDGE_BOTH);
+                    }
+                    if(edge_run(forward_fast) ||
+                       (MS_SINCE(bl_move_start) >= 3500 && (left || right))){
                         turn_off_motors();
+                        edge_stop();
                         BLState = INTERCEPT;
-                        timer10s = 0;
+                        bl_state_start = now_ms();
 //                        break;
                     }
 
@@ -91,11 +115,11 @@ void BlackLineIntercept(void){
         case INTERCEPT:
             strcpy(display_line[0], " INTERCEPT ");
             display_changed = TRUE;
-            if(timer10s >= 600){
+            if(MS_SINCE(bl_state_start) >= 6000){
                 P6OUT  &= ~LCD_BACKLITE;
                 BLState = TURN;
-                wait = 0;
-                timer10s = 0;
+                bl_move_start = now_ms();
+                bl_state_start = now_ms();
             } else {
                 P6OUT  |= LCD_BACKLITE;
             }
@@ -104,54 +128,58 @@ void BlackLineIntercept(void){
         case TURN:
             strcpy(display_line[0], " BL TURN  ");
             display_changed = TRUE;
-            if(timer10s <= 600){
+            if(MS_SINCE(bl_state_start) <= 6000){
                 P6OUT  |= LCD_BACKLITE;
-                wait = 0;
+                bl_move_start = now_ms();
                 break;
             } else {
                 P6OUT  &= ~LCD_BACKLITE;
             }
-            if(wait <= 5){
+            if(MS_SINCE(bl_move_start) <= 50){
                 spin_counterclockwise();
-            } else if(ADC_Right_Det > 600){
+                break;
+            }
+            edge_arm(EDGE_RIGHT);
+            if(edge_run(spin_counterclockwise) || right){
                 turn_off_motors();
+                edge_stop();
                 BLState = TRAVEL;
-                timer10s = 0;
+                bl_state_start = now_ms();
                 break;
             }
             break;
         case TRAVEL:
             strcpy(display_line[0], " BL TRAVEL");
             display_changed = TRUE;
-            if(timer10s < 600){
+            if(MS_SINCE(bl_state_start) < 6000){
                 P6OUT  |= LCD_BACKLITE;
                 break;
             } else {
                 P6OUT  &= ~LCD_BACKLITE;
             }
-            if(timer10s >= 5000){       // change to circle for display after 40 seconds
+            if(MS_SINCE(bl_state_start) >= 50000){       // change to circle for display after 40 seconds
                 BLState = CIRCLE;
-                timer10s = 0;
+                bl_state_start = now_ms();
                 turn_off_motors();
                 break;
             }
             turn_on_forward();
-            if (ADC_Right_Det < 600) BLState = RIGHTTRAVEL;
-            else if (ADC_Left_Det < 600) BLState = LEFTTRAVEL;
+            if (!right) BLState = RIGHTTRAVEL;
+            else if (!left) BLState = LEFTTRAVEL;
             break;
         case RIGHTTRAVEL:
             spin_clockwise();
-            if (ADC_Right_Det > 600) BLState = TRAVEL;
+            if (right) BLState = TRAVEL;
             break;
         case LEFTTRAVEL:
             spin_counterclockwise();
-            if (ADC_Left_Det > 600) BLState = TRAVEL;
+            if (left) BLState = TRAVEL;
             break;
         case CIRCLE:
 
             strcpy(display_line[0], " BL CIRCLE");
             display_changed = TRUE;
-            if(timer10s < 600){
+            if(MS_SINCE(bl_state_start) < 6000){
                 P6OUT  |= LCD_BACKLITE;
                 turn_off_motors();
                 break;
@@ -161,19 +189,19 @@ void BlackLineIntercept(void){
 
 
             turn_on_forward();
-            if (ADC_Right_Det < 600) BLState = RIGHTCIRCLE;
-            else if (ADC_Left_Det < 600) BLState = LEFTCIRCLE;
+            if (!right) BLState = RIGHTCIRCLE;
+            else if (!left) BLState = LEFTCIRCLE;
             break;
         case RIGHTCIRCLE:
             spin_clockwise();
-            if (ADC_Right_Det > 600) BLState = CIRCLE;
+            if (right) BLState = CIRCLE;
             break;
         case LEFTCIRCLE:
             spin_counterclockwise();
-            if (ADC_Left_Det > 600) BLState = CIRCLE;
+            if (left) BLState = CIRCLE;
             break;
         case EXIT:
-            if(wait < 600){
+            if(MS_SINCE(bl_move_start) < 6000){
                 turn_off_motors();
                 P6OUT |= LCD_BACKLITE;
                 strcpy(display_line[0], " BL EXIT  ");
@@ -183,11 +211,11 @@ void BlackLineIntercept(void){
                 P6OUT &= ~LCD_BACKLITE;
             }
 
-            if(wait <= 633){
+            if(MS_SINCE(bl_move_start) <= 6330){
                 spin_clockwise();
                 break;
             }
-            if(wait <= 1000){
+            if(MS_SINCE(bl_move_start) <= 10000){
                 forward_fast();
                 break;
             }
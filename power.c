@@ -0,0 +1,110 @@
+/*
+ * power.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file puts the CPU to sleep between main loop passes when there
+ *  is nothing left to do, instead of spinning until the next tick.
+ *  There is work when a scheduler task is due or when the IOT RX ISR
+ *  has stored bytes since the last check. Otherwise the CPU enters
+ *  LPM0 until an ISR wakes it with POWER_WAKE(): the Timer B0 tick,
+ *  an IOT byte, a new pair of line detector readings or a switch
+ *  press. ISRs that leave nothing for the main loop (TX, debounce,
+ *  the other ADC slots) let it sleep on.
+ *
+ *  LPM0 only stops the CPU. SMCLK keeps running because the UARTs,
+ *  the wheel PWM and Timer B0 all use it, so a deeper mode would stop
+ *  the robot. Waking from LPM0 takes a few cycles, which keeps the
+ *  command latency the same.
+ *
+ *  The time spent asleep and the time from the waking ISR to the main
+ *  loop running again are measured with TB0R and sent in the status
+ *  frame for the period since the previous one.
+ *
+ *  Functions included:
+ *    - Init_Power: Clears the sleep statistics.
+ *    - Idle_Process: Sleeps until an ISR has work for the main loop.
+ *    - power_status: Puts the sleep statistics in a status frame.
+ *
+ */
+
+
+#include "msp430.h"
+#include "functions.h"
+#include "macros.h"
+#include "power.h"
+#include "ringbuf.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "timebase.h"
+
+extern ring_buf iot_rx_ring;
+
+volatile unsigned char power_asleep;
+volatile unsigned int power_wake_at;
+unsigned int power_rx_head;             // iot_rx_ring head at the last check
+unsigned long power_window_start;       // now_ms() at the last status frame
+unsigned long power_sleep_us;
+unsigned long power_wake_sum;
+unsigned int power_wakes;
+unsigned int power_wake_max;
+
+void Init_Power(void){
+    power_asleep = FALSE;
+    power_rx_head = iot_rx_ring.head;
+    power_window_start = now_ms();
+    power_sleep_us = 0;
+    power_wake_sum = 0;
+    power_wakes = 0;
+    power_wake_max = 0;
+}
+
+//-----------------------------------------------------------------
+// Called after every pass. Interrupts are off between the check and
+// the sleep, so an ISR that arrives in between is only taken once
+// LPM0 is entered and wakes the CPU straight away.
+//-----------------------------------------------------------------
+void Idle_Process(void){
+    unsigned int start;
+    unsigned int woke;
+    unsigned int us;
+
+    __disable_interrupt();
+    if(iot_rx_ring.head != power_rx_head || sched_due()){
+        power_rx_head = iot_rx_ring.head;
+        __enable_interrupt();
+        return;
+    }
+    start = TB0R;
+    power_asleep = TRUE;
+    __bis_SR_register(LPM0_bits | GIE); // Until POWER_WAKE()
+    __no_operation();
+    woke = TB0R;
+    power_rx_head = iot_rx_ring.head;
+
+    power_sleep_us += (unsigned int)(power_wake_at - start);    // TB0R counts 1 us
+    us = woke - power_wake_at;
+    power_wake_sum += us;
+    power_wakes++;
+    if(us > power_wake_max){
+        power_wake_max = us;
+    }
+}
+
+void power_status(unsigned char *status){
+    unsigned long now = now_ms();
+    unsigned long window_ms = TIME_SINCE(now, power_window_start);
+
+    put_u16(&status[TLM_ST_SLEEP], window_ms ? power_sleep_us / window_ms : 0);
+    put_u16(&status[TLM_ST_WAKE_AVG], power_wakes ? power_wake_sum / power_wakes : 0);
+    put_u16(&status[TLM_ST_WAKE_MAX], power_wake_max);
+
+    power_window_start = now;
+    power_sleep_us = 0;
+    power_wake_sum = 0;
+    power_wakes = 0;
+    power_wake_max = 0;
+}
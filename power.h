@@ -0,0 +1,35 @@
+/*
+ * power.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Low power idle between main loop passes. The CPU sleeps in LPM0
+ *  and an ISR that leaves work for the main loop wakes it with
+ *  POWER_WAKE().
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+extern volatile unsigned char power_asleep;
+extern volatile unsigned int power_wake_at;    // TB0R when an ISR woke the CPU
+
+//------------------------------------------------------------------------------
+// Used from ISRs only, after the ISR has stored its work. Keeps the
+// CPU awake once the ISR returns. Needs msp430.h and macros.h.
+//------------------------------------------------------------------------------
+#define POWER_WAKE()                                \
+    do {                                            \
+        if(power_asleep){                           \
+            power_asleep = FALSE;                   \
+            power_wake_at = TB0R;                   \
+            __bic_SR_register_on_exit(LPM0_bits);   \
+        }                                           \
+    } while(0)
+
+void Init_Power(void);
+void Idle_Process(void);
+void power_status(unsigned char *status);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,134 @@
+/*
+ * ringbuf.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file contains the single-producer / single-consumer ring buffer
+ *  used between the UART interrupts and the main loop. The ISR owns the
+ *  head, the main loop owns the tail, and each side only publishes its
+ *  index after the data it covers is in place. Overrun and high water
+ *  counters are kept so the buffer sizes can be checked on the car.
+ *
+ *  Functions included:
+ *    - ring_init: Attaches storage to a ring and clears its counters.
+ *    - ring_count: Returns the number of bytes waiting.
+ *    - ring_space: Returns the number of free bytes.
+ *    - ring_put: Producer, adds one byte or counts an overrun.
+ *    - ring_write: Producer, adds a block of bytes.
+ *    - ring_get: Consumer, removes one byte.
+ *    - ring_peek_at: Consumer, reads a waiting byte without removing it.
+ *    - ring_peek: Consumer, returns the contiguous block waiting.
+ *    - ring_consume: Consumer, releases bytes returned by ring_peek.
+ *    - ring_flush: Consumer, drops everything waiting.
+ *
+ */
+
+
+#include "ringbuf.h"
+#include "macros.h"
+
+void ring_init(ring_buf *ring, char *storage, unsigned int size){
+    ring->buf = storage;
+    ring->mask = size - 1;
+    ring->head = BEGINNING;
+    ring->tail = BEGINNING;
+    ring->overrun = 0;
+    ring->high_water = 0;
+}
+
+unsigned int ring_count(const ring_buf *ring){
+    return ring->head - ring->tail;
+}
+
+unsigned int ring_space(const ring_buf *ring){
+    return (ring->mask + 1) - (ring->head - ring->tail);
+}
+
+//-----------------------------------------------------------------
+// Producer side
+// The byte is stored before head moves, so the consumer never sees
+// a slot that has not been written yet.
+//-----------------------------------------------------------------
+char ring_put(ring_buf *ring, char c){
+    unsigned int head = ring->head;
+    unsigned int used = head - ring->tail;
+
+    if(used > ring->mask){
+        ring->overrun++;
+        return FALSE;
+    }
+    ((volatile char *)ring->buf)[head & ring->mask] = c;
+    ring->head = head + 1;
+    if(++used > ring->high_water){
+        ring->high_water = used;
+    }
+    return TRUE;
+}
+
+unsigned int ring_write(ring_buf *ring, const char *data, unsigned int length){
+    unsigned int head = ring->head;
+    unsigned int space = ring_space(ring);
+    unsigned int i;
+
+    if(length > space){
+        ring->overrun += length - space;
+        length = space;
+    }
+    for(i = 0; i < length; i++){
+        ((volatile char *)ring->buf)[(head + i) & ring->mask] = data[i];
+    }
+    ring->head = head + length;
+    if(ring_count(ring) > ring->high_water){
+        ring->high_water = ring_count(ring);
+    }
+    return length;
+}
+
+//-----------------------------------------------------------------
+// Consumer side
+// ring_peek hands back a pointer into the storage instead of copying,
+// so a parser can walk a whole block and then release it with a
+// single ring_consume. A wrapped ring takes two peeks to drain.
+//-----------------------------------------------------------------
+char ring_get(ring_buf *ring, char *c){
+    unsigned int tail = ring->tail;
+
+    if(ring->head == tail){
+        return FALSE;
+    }
+    *c = ((volatile char *)ring->buf)[tail & ring->mask];
+    ring->tail = tail + 1;
+    return TRUE;
+}
+
+char ring_peek_at(const ring_buf *ring, unsigned int offset){
+    return ((volatile char *)ring->buf)[(ring->tail + offset) & ring->mask];
+}
+
+unsigned int ring_peek(const ring_buf *ring, const char **data){
+    unsigned int tail = ring->tail;
+    unsigned int count = ring->head - tail;
+    unsigned int to_end = (ring->mask + 1) - (tail & ring->mask);
+
+    *data = &ring->buf[tail & ring->mask];
+    if(count > to_end){
+        count = to_end;
+    }
+    return count;
+}
+
+void ring_consume(ring_buf *ring, unsigned int length){
+    unsigned int count = ring->head - ring->tail;
+
+    if(length > count){
+        length = count;
+    }
+    ring->tail += length;
+}
+
+void ring_flush(ring_buf *ring){
+    ring->tail = ring->head;
+}
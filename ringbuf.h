@@ -0,0 +1,46 @@
+/*
+ * ringbuf.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Single-producer / single-consumer byte ring used by the UART paths.
+ *  Only depends on the standard C types so the module also builds on the
+ *  host, outside of Code Composer Studio.
+ */
+
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+//------------------------------------------------------------------------------
+// head and tail are free running 16 bit counters, the storage index is the
+// counter masked by (size - 1). The size must be a power of two so the mask
+// stays correct when the counters wrap past 0xFFFF.
+// Only the producer (usually an ISR) stores head, only the consumer stores
+// tail, so neither side needs to disable interrupts.
+//------------------------------------------------------------------------------
+typedef struct {
+    char *buf;                          // Storage, size is a power of two
+    unsigned int mask;                  // size - 1
+    volatile unsigned int head;         // Next write, written by producer only
+    volatile unsigned int tail;         // Next read, written by consumer only
+    volatile unsigned int overrun;      // Bytes dropped because ring was full
+    volatile unsigned int high_water;   // Most bytes ever waiting at once
+} ring_buf;
+
+void ring_init(ring_buf *ring, char *storage, unsigned int size);
+unsigned int ring_count(const ring_buf *ring);
+unsigned int ring_space(const ring_buf *ring);
+
+// Producer side
+char ring_put(ring_buf *ring, char c);
+unsigned int ring_write(ring_buf *ring, const char *data, unsigned int length);
+
+// Consumer side
+char ring_get(ring_buf *ring, char *c);
+char ring_peek_at(const ring_buf *ring, unsigned int offset);
+unsigned int ring_peek(const ring_buf *ring, const char **data);
+void ring_consume(ring_buf *ring, unsigned int length);
+void ring_flush(ring_buf *ring);
+
+#endif /* RINGBUF_H_ */
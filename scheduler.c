@@ -0,0 +1,174 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file runs the main loop's jobs from a fixed task table instead
+ *  of calling each one as fast as the loop spins. A task either runs on
+ *  every pass (the IOT link and the motion state machine, which must
+ *  react to received bytes straight away) or is released every
+ *  <period> ticks of Timer B0, starting <phase> ticks in. When several
+ *  tasks are due the one with the lowest priority number runs first.
+ *
+ *  Every run is timed with now_us(). Run count, average and worst time are
+ *  kept per task, along with how often it went over its budget and how
+ *  often it started a whole period late. ^0000K3 sends them as a
+ *  telemetry frame.
+ *
+ *  Functions included:
+ *    - Init_Scheduler: Sets the first release of every task.
+ *    - Scheduler_Run: One pass, runs every task that is due.
+ *    - sched_pick: Finds the due task with the best priority.
+ *    - sched_due: Tells the idle loop whether a timed task is due.
+ *    - sched_report: Sends the task statistics as a telemetry frame.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "timebase.h"
+
+extern volatile unsigned long system_ticks;
+
+//-----------------------------------------------------------------
+// Task table. The order is the order of the telemetry frame.
+//-----------------------------------------------------------------
+const sched_task sched_tasks[] = {
+    //  run                 period ticks        phase  priority  budget us
+    { bootIOT,              SCHED_EVERY_PASS,   0,     0,        2000 },
+    { movement_machine,     SCHED_EVERY_PASS,   0,     1,        500  },
+    { Serial_Process,       MS_TO_TICKS(10),    0,     2,        200  },
+    { Telemetry_Process,    MS_TO_TICKS(10),    0,     3,        3000 },
+    { Seconds_Process,      MS_TO_TICKS(10),    0,     4,        3000 },
+    { Display_Process,      MS_TO_TICKS(10),    0,     5,        8000 },
+    { Calibration_Process,  MS_TO_TICKS(10),    0,     6,        500  },
+    { Battery_Process,      MS_TO_TICKS(100),   0,     7,        500  },
+};
+const unsigned char sched_task_count = sizeof(sched_tasks) / sizeof(sched_tasks[0]);
+
+sched_stats sched_stats_table[sizeof(sched_tasks) / sizeof(sched_tasks[0])];
+unsigned int sched_pass;
+
+unsigned char sched_pick(unsigned int now);
+
+void Init_Scheduler(void){
+    unsigned int now = (unsigned int)system_ticks;
+    unsigned char i;
+
+    memset(sched_stats_table, 0, sizeof(sched_stats_table));
+    sched_pass = 0;
+    for(i = 0; i < sched_task_count; i++){
+        sched_stats_table[i].next = now + sched_tasks[i].phase;
+        sched_stats_table[i].last_pass = sched_pass - 1;
+    }
+}
+
+unsigned char sched_pick(unsigned int now){
+    const sched_task *task;
+    sched_stats *stats;
+    unsigned char best = SCHED_NONE;
+    unsigned char i;
+    char due;
+
+    for(i = 0; i < sched_task_count; i++){
+        task = &sched_tasks[i];
+        stats = &sched_stats_table[i];
+        if(task->period == SCHED_EVERY_PASS){
+            due = stats->last_pass != sched_pass;
+        } else {
+            due = (int)(now - stats->next) >= 0;
+        }
+        if(due && (best == SCHED_NONE || task->priority < sched_tasks[best].priority)){
+            best = i;
+        }
+    }
+    return best;
+}
+
+//-----------------------------------------------------------------
+// Every-pass tasks do not count, they only have work after an ISR
+// and that ISR wakes the CPU itself.
+//-----------------------------------------------------------------
+char sched_due(void){
+    unsigned int now = (unsigned int)system_ticks;
+    unsigned char i;
+
+    for(i = 0; i < sched_task_count; i++){
+        if(sched_tasks[i].period != SCHED_EVERY_PASS &&
+           (int)(now - sched_stats_table[i].next) >= 0){
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//-----------------------------------------------------------------
+// One pass of the main loop. Tasks released while another one runs
+// are picked up in the same pass.
+//-----------------------------------------------------------------
+void Scheduler_Run(void){
+    const sched_task *task;
+    sched_stats *stats;
+    unsigned int now;
+    unsigned long start;
+    unsigned long us;
+    unsigned char i;
+
+    sched_pass++;
+    while(ALWAYS){
+        now = (unsigned int)system_ticks;
+        if((i = sched_pick(now)) == SCHED_NONE){
+            break;
+        }
+        task = &sched_tasks[i];
+        stats = &sched_stats_table[i];
+
+        if(task->period == SCHED_EVERY_PASS){
+            stats->last_pass = sched_pass;
+        } else if(now - stats->next >= task->period){
+            stats->late++;              // Missed a release, skip to the next one
+            stats->next = now + task->period;
+        } else {
+            stats->next += task->period;
+        }
+
+        start = now_us();
+        task->run();
+        us = US_SINCE(start);
+
+        stats->runs++;
+        stats->total_us += us;
+        if(us > stats->worst_us){
+            stats->worst_us = us < 0xFFFF ? us : 0xFFFF;
+        }
+        if(us > task->budget_us){
+            stats->overruns++;
+        }
+    }
+}
+
+void sched_report(void){
+    unsigned char payload[TLM_TASKS_MAX * TLM_TASK_LEN];
+    unsigned char *p = payload;
+    sched_stats *stats;
+    unsigned char i;
+
+    for(i = 0; i < sched_task_count && i < TLM_TASKS_MAX; i++){
+        stats = &sched_stats_table[i];
+        put_u32(&p[TLM_TK_RUNS], stats->runs);
+        put_u16(&p[TLM_TK_AVG], stats->runs ? stats->total_us / stats->runs : 0);
+        put_u16(&p[TLM_TK_WORST], stats->worst_us);
+        put_u16(&p[TLM_TK_OVERRUNS], stats->overruns);
+        put_u16(&p[TLM_TK_LATE], stats->late);
+        p += TLM_TASK_LEN;
+    }
+    telemetry_send(TLM_TYPE_TASKS, payload, p - payload);
+}
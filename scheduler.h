@@ -0,0 +1,44 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Cooperative scheduler for the main loop. Tasks come from a const
+ *  table and are released by the Timer B0 tick (TICK_MS).
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#define SCHED_EVERY_PASS    (0)     // Period for tasks run on every pass
+#define SCHED_NONE          (0xFF)
+
+typedef struct {
+    void (*run)(void);
+    unsigned int period;            // Ticks between releases, 0 = every pass
+    unsigned int phase;             // Ticks after start of the first release
+    unsigned char priority;         // 0 runs first when several are due
+    unsigned int budget_us;         // Longer runs are counted as overruns
+} sched_task;
+
+typedef struct {
+    unsigned int next;              // Tick of the next release
+    unsigned int last_pass;         // Pass an every-pass task last ran in
+    unsigned long runs;
+    unsigned long total_us;
+    unsigned int worst_us;
+    unsigned int overruns;          // Ran longer than budget_us
+    unsigned int late;              // Started a whole period or more late
+} sched_stats;
+
+extern const sched_task sched_tasks[];
+extern sched_stats sched_stats_table[];
+extern const unsigned char sched_task_count;
+
+void Init_Scheduler(void);
+void Scheduler_Run(void);
+char sched_due(void);
+void sched_report(void);
+
+#endif /* SCHEDULER_H_ */
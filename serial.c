@@ -9,13 +9,25 @@
  *  This file contains functions to initialize and manage serial communication
  *  using the MSP430's USCI_A0 and USCI_A1 modules. It sets up UART communication
  *  for both the USB and IOT interfaces, handles transmission and reception of data,
- *  and includes interrupt service routines for both modules.
+ *  and includes interrupt service routines for both modules. Received bytes
+ *  are placed in iot_rx_ring / usb_rx_ring for the main loop to drain
+ *  (iot_commands and usb_commands in commands.c), and
+ *  outgoing data is sent from the iot_tx_queue / usb_tx_queue descriptors.
+ *  Bytes mirrored between the two ports go through the bridge (bridge.c)
+ *  and are only written to TXBUF from the TX interrupt.
  *
  *  Functions included:
  *    - USCI_A0_transmit: Starts a transmission on UCA0.
+ *    - iot_send: Queues bytes for the IOT module without copying them.
+ *    - iot_send_str: Queues a NULL terminated string for the IOT module.
+ *    - usb_send: Queues bytes for the USB port without copying them.
+ *    - usb_send_str: Queues a NULL terminated string for the USB port.
+ *    - uart_tx_next: Picks the next byte from a TX queue or bridge path.
  *    - Init_Serial: Initializes both UCA0 and UCA1 serial modules.
  *    - Init_Serial_UCA0: Configures UCA0 for UART communication.
  *    - Init_Serial_UCA1: Configures UCA1 for UART communication.
+ *    - iot_set_baud: Asks the ESP32 to change rate, UCA0 follows it.
+ *    - Serial_Process: Runs USB commands, finishes a pending IOT rate change.
  *    - eUSCI_A0_ISR: Interrupt service routine for UCA0 RX and TX.
  *    - eUSCI_A1_ISR: Interrupt service routine for UCA1 RX and TX.
  *
@@ -28,18 +40,57 @@
 #include "LCD.h"
 #include "ports.h"
 #include "macros.h"
+#include "ringbuf.h"
+#include "txqueue.h"
+#include "bridge.h"
+#include "baud.h"
+#include "latency.h"
+#include "power.h"
+#include "timebase.h"
+#include "isrprof.h"
 
-unsigned int usb_tx;
-unsigned int usb_rx;
-char usb_tx_buf[160];
-char usb_rx_buf[160];
-unsigned int iot_tx;
-unsigned int iot_rx;
-char iot_tx_buf[160];
-char iot_rx_buf[160];
+char usb_rx_buf[USB_RX_SIZE];
+ring_buf usb_rx_ring;
+tx_queue usb_tx_queue;
+char iot_rx_buf[IOT_RX_SIZE];
+ring_buf iot_rx_ring;
+tx_queue iot_tx_queue;
 
 extern unsigned int cmdFram;
 
+//------------------------------------------------------------------------------
+// Divisors for every supported rate, computed from SMCLK_FREQ by the
+// compiler and kept in FRAM.
+//------------------------------------------------------------------------------
+const baud_setting baud_table[BAUD_COUNT] = {
+    BAUD_ENTRY(9600),
+    BAUD_ENTRY(19200),
+    BAUD_ENTRY(38400),
+    BAUD_ENTRY(57600),
+    BAUD_ENTRY(115200),
+    BAUD_ENTRY(230400),
+    BAUD_ENTRY(460800),
+    BAUD_ENTRY(921600)
+};
+
+#if BAUD_ERROR(9600) > BAUD_MAX_ERROR || BAUD_ERROR(19200) > BAUD_MAX_ERROR || \
+    BAUD_ERROR(38400) > BAUD_MAX_ERROR || BAUD_ERROR(57600) > BAUD_MAX_ERROR || \
+    BAUD_ERROR(115200) > BAUD_MAX_ERROR || BAUD_ERROR(230400) > BAUD_MAX_ERROR || \
+    BAUD_ERROR(460800) > BAUD_MAX_ERROR || BAUD_ERROR(921600) > BAUD_MAX_ERROR
+#error "A baud_table rate is out of tolerance for this SMCLK_FREQ"
+#endif
+#if BAUD_N(921600) < 3
+#error "SMCLK_FREQ is too slow for 921600 baud"
+#endif
+
+char iot_baud;                          // Current IOT link rate, baud_table index
+char usb_baud;
+char iot_baud_pending = BAUD_NONE;      // Rate waiting for the ESP32 to switch
+volatile unsigned char iot_baud_sent;
+unsigned long iot_baud_start;           // now_ms() when the rate change command went out
+
+static char uart_tx_next(tx_queue *queue, bridge_path *path, char *c);
+
 // Global Variables
 // Size for appropriate Command Length
 // Index for process_buffer
@@ -51,12 +102,50 @@ void USCI_A0_transmit(void) {
     UCA0IE |= UCTXIE; // Enable TX interrupt
 }
 
+//-----------------------------------------------------------------
+// Queue data for transmission. The bytes are sent straight from the
+// caller's buffer, so string literals cost nothing and a caller
+// buffer must not change until its done flag is TRUE.
+// Returns FALSE if the descriptor queue is full.
+//-----------------------------------------------------------------
+char iot_send(const char *data, unsigned int length, volatile unsigned char *done) {
+    if (!tx_queue_add(&iot_tx_queue, data, length, done)) {
+        return FALSE;
+    }
+    UCA0IE |= UCTXIE; // TX interrupt pulls from the queue
+    return TRUE;
+}
+
+char iot_send_str(const char *string) {
+    return iot_send(string, strlen(string), NULL);
+}
+
+char usb_send(const char *data, unsigned int length, volatile unsigned char *done) {
+    if (!tx_queue_add(&usb_tx_queue, data, length, done)) {
+        return FALSE;
+    }
+    UCA1IE |= UCTXIE;
+    return TRUE;
+}
+
+char usb_send_str(const char *string) {
+    return usb_send(string, strlen(string), NULL);
+}
+
 void Init_Serial(void) {
-    Init_Serial_UCA1('0');
-    Init_Serial_UCA0('0');
+    ring_init(&iot_rx_ring, iot_rx_buf, sizeof(iot_rx_buf));
+    ring_init(&usb_rx_ring, usb_rx_buf, sizeof(usb_rx_buf));
+    tx_queue_init(&iot_tx_queue);
+    tx_queue_init(&usb_tx_queue);
+    Init_Bridge();
+    Init_Serial_UCA1(USB_BAUD);
+    Init_Serial_UCA0(IOT_BAUD);
 }
 
 void Init_Serial_UCA0(char speed) {
+    if ((unsigned char)speed >= BAUD_COUNT) {
+        speed = IOT_BAUD;
+    }
     UCA0CTLW0 = 0;
     UCA0CTLW0 |= UCSWRST;
     UCA0CTLW0 |= UCSSEL__SMCLK;
@@ -67,14 +156,21 @@ void Init_Serial_UCA0(char speed) {
     UCA0CTLW0 &= ~UC7BIT;
     UCA0CTLW0 |= UCMODE_0;
 
-    UCA0BRW = 4; // 115200 baud
-    UCA0MCTLW = 0x5551;
+    UCA0BRW = baud_table[speed].brw;
+    UCA0MCTLW = baud_table[speed].mctlw;
 
     UCA0CTLW0 &= ~UCSWRST;
     UCA0IE |= UCRXIE;
+    if (tx_queue_pending(&iot_tx_queue)) {
+        UCA0IE |= UCTXIE; // UCSWRST cleared it
+    }
+    iot_baud = speed;
 }
 
 void Init_Serial_UCA1(char speed) {
+    if ((unsigned char)speed >= BAUD_COUNT) {
+        speed = USB_BAUD;
+    }
     UCA1CTLW0 = 0;
     UCA1CTLW0 |= UCSWRST;
     UCA1CTLW0 |= UCSSEL__SMCLK;
@@ -85,77 +181,143 @@ void Init_Serial_UCA1(char speed) {
     UCA1CTLW0 &= ~UC7BIT;
     UCA1CTLW0 |= UCMODE_0;
 
-    UCA1BRW = 4; // 115200 baud
-    UCA1MCTLW = 0x5551;
+    UCA1BRW = baud_table[speed].brw;
+    UCA1MCTLW = baud_table[speed].mctlw;
 
     UCA1CTLW0 &= ~UCSWRST;
     UCA1IE |= UCRXIE;
+    if (tx_queue_pending(&usb_tx_queue)) {
+        UCA1IE |= UCTXIE;
+    }
+    usb_baud = speed;
+}
+
+//-----------------------------------------------------------------
+// Change the IOT link rate at run time. The matching AT+UART_CUR is
+// queued first; the ESP32 answers OK at the old rate and then
+// switches, so UCA0 is only reprogrammed by Serial_Process once the
+// command is out and IOT_BAUD_SETTLE ms have passed.
+// Anything queued for the ESP32 in that window still goes out at
+// the old rate.
+//-----------------------------------------------------------------
+char iot_set_baud(char speed) {
+    const char *command;
+
+    if ((unsigned char)speed >= BAUD_COUNT || iot_baud_pending != BAUD_NONE) {
+        return FALSE;
+    }
+    if (speed == iot_baud) {
+        return TRUE;
+    }
+    command = baud_table[speed].at_command;
+    if (!iot_send(command, strlen(command), &iot_baud_sent)) {
+        return FALSE;
+    }
+    iot_baud_pending = speed;
+    return TRUE;
+}
+
+void Serial_Process(void) {
+    usb_commands();                     // usb_rx_ring holds 11 ms at 115200
+    if (iot_baud_pending == BAUD_NONE) {
+        return;
+    }
+    if (!iot_baud_sent) {
+        iot_baud_start = now_ms();         // Still waiting in the queue
+        return;
+    }
+    if (MS_SINCE(iot_baud_start) < IOT_BAUD_SETTLE || (UCA0STATW & UCBUSY)) {
+        return;
+    }
+    Init_Serial_UCA0(iot_baud_pending);
+    iot_baud_pending = BAUD_NONE;
+}
+
+//-----------------------------------------------------------------
+// Picks the next byte for a UART from its own descriptor queue and
+// from the bridge path feeding it. A descriptor that has started is
+// always finished first, then a bridged line that has started, so
+// the two streams only interleave at line boundaries unless the
+// bridged line stalls.
+//-----------------------------------------------------------------
+static char uart_tx_next(tx_queue *queue, bridge_path *path, char *c) {
+    if (queue->sent) {
+        return tx_queue_next(queue, c);
+    }
+    if (path->mid_line && bridge_next(path, c)) {
+        return TRUE;
+    }
+    if (tx_queue_next(queue, c)) {
+        return TRUE;
+    }
+    return bridge_next(path, c);
 }
 
 #pragma vector = EUSCI_A0_VECTOR
 __interrupt void eUSCI_A0_ISR(void) {
     char iot_receive;
+    char iot_transmit;
+    ISR_PROF_ENTER(ISR_PROF_UCA0);
 
     switch (__even_in_range(UCA0IV, 0x08)) {
         case 0:
             break;
         case 2:
+            if (UCA0STATW & UCOE) {
+                iot_to_usb.overrun++; // Lost a byte before this one
+            }
             iot_receive = UCA0RXBUF;
-            iot_rx_buf[iot_rx++] = iot_receive;
-            if (iot_rx >= sizeof(iot_rx_buf)) {
-                iot_rx = BEGINNING;
+            if (ring_put(&iot_rx_ring, iot_receive) && iot_receive == '^') {
+                lat_rx_isr(iot_rx_ring.head - 1); // Command latency starts here
+            }
+            POWER_WAKE();
+            if (bridge_rx(&iot_to_usb, iot_receive)) {
+                UCA1IE |= UCTXIE; // USB TX interrupt forwards it
             }
-            UCA1TXBUF = iot_receive;
             break;
         case 4:
-            if (iot_tx_buf[iot_tx] == '\n') {
-                UCA0TXBUF = iot_tx_buf[iot_tx];
-                iot_tx_buf[iot_tx] = 0x00;
-                UCA0IE &= ~UCTXIE;
-                iot_tx = 0;
-                break;
+            if (uart_tx_next(&iot_tx_queue, &usb_to_iot, &iot_transmit)) {
+                UCA0TXBUF = iot_transmit;
             } else {
-                UCA0TXBUF = iot_tx_buf[iot_tx];
-                iot_tx_buf[iot_tx] = 0x00;
+                UCA0IE &= ~UCTXIE; // Queue empty
             }
-            iot_tx++;
             break;
         default:
             break;
     }
+    ISR_PROF_EXIT(ISR_PROF_UCA0);
 }
 
 #pragma vector = EUSCI_A1_VECTOR
 __interrupt void eUSCI_A1_ISR(void) {
     char usb_receive;
+    char usb_transmit;
+    ISR_PROF_ENTER(ISR_PROF_UCA1);
 
     switch (__even_in_range(UCA1IV, 0x08)) {
         case 0:
             break;
         case 2:
+            if (UCA1STATW & UCOE) {
+                usb_to_iot.overrun++;
+            }
             usb_receive = UCA1RXBUF;
-            usb_rx_buf[usb_rx++] = usb_receive;
-            if (usb_rx >= sizeof(usb_rx_buf)) {
-                usb_rx = BEGINNING;
+            ring_put(&usb_rx_ring, usb_receive);
+            if (bridge_rx(&usb_to_iot, usb_receive)) {
+                UCA0IE |= UCTXIE; // IOT TX interrupt forwards it
             }
-            UCA0TXBUF = usb_receive;
             break;
         case 4:
-            if (usb_tx_buf[usb_tx] == '\n') {
-                UCA1TXBUF = usb_tx_buf[usb_tx];
-                usb_tx_buf[usb_tx] = 0x00;
-                UCA1IE &= ~UCTXIE;
-                usb_tx = 0;
-                break;
+            if (uart_tx_next(&usb_tx_queue, &iot_to_usb, &usb_transmit)) {
+                UCA1TXBUF = usb_transmit;
             } else {
-                UCA1TXBUF = usb_tx_buf[usb_tx];
-                usb_tx_buf[usb_tx] = 0x00;
+                UCA1IE &= ~UCTXIE; // Queue empty
             }
-            usb_tx++;
             break;
         default:
             break;
     }
+    ISR_PROF_EXIT(ISR_PROF_UCA1);
 }
 
 
@@ -24,6 +24,8 @@
 #include  "LCD.h"
 #include  "ports.h"
 #include "macros.h"
+#include "power.h"
+#include "isrprof.h"
 
 char display_line[4][11];
 volatile unsigned char display_changed;
@@ -36,16 +38,15 @@ volatile unsigned char choice;
 volatile unsigned char state;
 unsigned int okay_to_look_at_switch1 = OKAY;
 volatile unsigned int sw1_position;
-volatile unsigned int count_debounce_SW1;
 unsigned int okay_to_look_at_switch2 = OKAY;
 volatile unsigned int sw2_position;
-volatile unsigned int count_debounce_SW2;
 volatile unsigned int start_instruction;
 volatile unsigned int Backlite;
 
 
 #pragma vector=PORT4_VECTOR
 __interrupt void switchP4_interrupt(void){          // Switch 1
+    ISR_PROF_ENTER(ISR_PROF_PORT4);
     if (P4IFG & SW1) {
         P4IFG &= ~SW1; // IFG SW1 cleared
         P4IE &= ~SW1;
@@ -53,15 +54,15 @@ __interrupt void switchP4_interrupt(void){          // Switch 1
         TB0CCTL1 |= CCIE;
 
         sw1_position = 1;
-        count_debounce_SW1 = 10;
+        POWER_WAKE();
     }
-
-
+    ISR_PROF_EXIT(ISR_PROF_PORT4);
 }
 
 
 #pragma vector=PORT2_VECTOR
 __interrupt void switchP2_interrupt(void){          // Switch 2
+    ISR_PROF_ENTER(ISR_PROF_PORT2);
     if (P2IFG & SW2) {
         P2IFG &= ~SW2; // IFG SW2 cleared
         P4IE &= ~SW2;
@@ -69,8 +70,9 @@ __interrupt void switchP2_interrupt(void){          // Switch 2
         TB0CCTL2 |= CCIE;
 
         sw2_position = 1;
-        count_debounce_SW2 = 10;
+        POWER_WAKE();
     }
+    ISR_PROF_EXIT(ISR_PROF_PORT2);
 }
 
 
@@ -0,0 +1,139 @@
+/*
+ * swtimer.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file keeps the software timers in one list sorted by expiry.
+ *  Every entry holds the number of ticks after the entry before it,
+ *  so the tick ISR only counts down the first one and takes off the
+ *  ones that reach zero. Its work depends on how many timers expire,
+ *  not on how many are running, and nothing is compared against an
+ *  absolute tick count, so the tick counter wrapping does not matter.
+ *
+ *  An expired timer sets its fired flag, which the owner reads with
+ *  swt_fired from the main loop. A periodic timer is put back in the
+ *  list by the ISR; if the owner falls behind, expiries it has not
+ *  read yet are merged into one. Timers that expire on the same tick
+ *  fire in the order they were started.
+ *
+ *  The list is only changed by the main loop with interrupts off, and
+ *  by the tick ISR. swt_start and swt_cancel put the interrupt state
+ *  back the way they found it, so they can be called from an ISR or
+ *  with interrupts already off. Only those two touch the hardware, and
+ *  only through the intrinsics, so tools/swtimer_test.c builds this
+ *  file on the host against tools/shim/msp430.h.
+ *
+ *  Functions included:
+ *    - swt_insert: Puts a timer in the list at its place.
+ *    - swt_unlink: Takes a timer out of the list.
+ *    - swt_start: Starts or restarts a one-shot or periodic timer.
+ *    - swt_cancel: Stops a timer and clears its fired flag.
+ *    - swt_running: Tells whether a timer is still counting.
+ *    - swt_fired: Reads and clears a timer's fired flag.
+ *    - swt_tick: Tick ISR side, expires the timers that are due.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "macros.h"
+#include "swtimer.h"
+
+sw_timer *swt_head;
+
+static void swt_insert(sw_timer *timer, unsigned int ticks){
+    sw_timer **link = &swt_head;
+
+    while(*link && (*link)->delta <= ticks){
+        ticks -= (*link)->delta;        // Same tick goes after, first started first
+        link = &(*link)->next;
+    }
+    if(*link){
+        (*link)->delta -= ticks;
+    }
+    timer->delta = ticks;
+    timer->next = *link;
+    timer->running = TRUE;
+    *link = timer;
+}
+
+static void swt_unlink(sw_timer *timer){
+    sw_timer **link;
+
+    for(link = &swt_head; *link; link = &(*link)->next){
+        if(*link == timer){
+            *link = timer->next;
+            if(timer->next){
+                timer->next->delta += timer->delta;
+            }
+            break;
+        }
+    }
+    timer->running = FALSE;
+}
+
+//-----------------------------------------------------------------
+// Expires after <ticks> ticks, then every <period> ticks unless
+// period is SWT_ONE_SHOT. 0 ticks is taken as the next tick.
+//-----------------------------------------------------------------
+void swt_start(sw_timer *timer, unsigned int ticks, unsigned int period){
+    unsigned int state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if(timer->running){
+        swt_unlink(timer);
+    }
+    timer->period = period;
+    timer->fired = FALSE;
+    swt_insert(timer, ticks ? ticks : 1);
+    __set_interrupt_state(state);
+}
+
+void swt_cancel(sw_timer *timer){
+    unsigned int state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if(timer->running){
+        swt_unlink(timer);
+    }
+    timer->fired = FALSE;
+    __set_interrupt_state(state);
+}
+
+char swt_running(const sw_timer *timer){
+    return timer->running;
+}
+
+char swt_fired(sw_timer *timer){
+    if(!timer->fired){
+        return FALSE;
+    }
+    timer->fired = FALSE;
+    return TRUE;
+}
+
+//-----------------------------------------------------------------
+// Called from Timer0_B0_ISR every tick. The first timer's delta is
+// never 0 between ticks.
+//-----------------------------------------------------------------
+void swt_tick(void){
+    sw_timer *timer;
+
+    if(!swt_head){
+        return;
+    }
+    swt_head->delta--;
+    while((timer = swt_head) != NULL && !timer->delta){
+        swt_head = timer->next;
+        timer->running = FALSE;
+        timer->fired = TRUE;
+        if(timer->period != SWT_ONE_SHOT){
+            swt_insert(timer, timer->period);
+        }
+    }
+}
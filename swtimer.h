@@ -0,0 +1,34 @@
+/*
+ * swtimer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Software timers run from the Timer B0 tick. Each module owns its
+ *  sw_timer structures and starts, cancels and polls them itself.
+ *  Elapsed time is measured with timebase.h instead. Include after
+ *  macros.h.
+ */
+
+#ifndef SWTIMER_H_
+#define SWTIMER_H_
+
+#define SWT_ONE_SHOT        (0)     // Period of a timer that runs once
+#define SWT_MAX_TICKS       (0xFFFF)    // Longest delay or period, ticks are unsigned int
+#define SWT_MAX_MS          (SWT_MAX_TICKS * (unsigned long)TICK_MS)
+
+typedef struct sw_timer {
+    struct sw_timer *next;          // Next timer to expire
+    unsigned int delta;             // Ticks after the timer before it
+    unsigned int period;            // Ticks between expiries, SWT_ONE_SHOT
+    volatile char running;          // In the list
+    volatile char fired;            // Expired since the owner last looked
+} sw_timer;
+
+void swt_start(sw_timer *timer, unsigned int ticks, unsigned int period);
+void swt_cancel(sw_timer *timer);
+char swt_running(const sw_timer *timer);
+char swt_fired(sw_timer *timer);
+void swt_tick(void);
+
+#endif /* SWTIMER_H_ */
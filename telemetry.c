@@ -0,0 +1,236 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file streams binary telemetry frames on the USB UART. A status
+ *  frame with the detector readings, line follower state, motor duty
+ *  cycles, serial buffer and motion queue counters is built every
+ *  telemetry_period ms. Frames are CRC-16 protected, COBS encoded and
+ *  handed to the USB TX queue. Two frame buffers are used; if both are still being
+ *  sent the frame is skipped and counted instead of waiting, so the
+ *  cost per period is one fixed size frame. The layout is in
+ *  telemetry.h and tools/telemetry_decode.c turns a capture into CSV.
+ *
+ *  Functions included:
+ *    - Init_Telemetry: Clears the frame buffers and sets the rate.
+ *    - Telemetry_Process: Sends a status frame when the period is up.
+ *    - telemetry_set_period: Changes the status frame rate, 0 = off.
+ *    - telemetry_send: Frames and queues any payload on the USB UART.
+ *    - telemetry_ready: Tells whether a frame buffer is free.
+ *    - crc16: CRC-16/CCITT-FALSE over a block of bytes.
+ *    - cobs_encode: COBS encodes a block and adds the delimiter.
+ *
+ */
+
+
+#include "msp430.h"
+#include <string.h>
+#include "functions.h"
+#include "LCD.h"
+#include "ports.h"
+#include "macros.h"
+#include "ringbuf.h"
+#include "txqueue.h"
+#include "bridge.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "power.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "isrprof.h"
+#include "adc.h"
+#include "battery.h"
+#include "capture.h"
+#include "edge.h"
+
+extern char BLState;
+extern char movement;
+extern ring_buf iot_rx_ring;
+extern ring_buf usb_rx_ring;
+extern unsigned int iot_boot_ms;
+
+sw_timer telemetry_timer;               // Periodic, one status frame per expiry
+unsigned long telemetry_period;         // ms
+unsigned int telemetry_seq;
+unsigned int telemetry_skipped;
+
+unsigned char tlm_frame[2][TLM_MAX_FRAME];
+volatile unsigned char tlm_frame_done[2];
+
+// CRC-16/CCITT-FALSE, one nibble at a time
+const unsigned int crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+void Init_Telemetry(void){
+    tlm_frame_done[0] = TRUE;
+    tlm_frame_done[1] = TRUE;
+    telemetry_seq = 0;
+    telemetry_skipped = 0;
+    telemetry_set_period(TELEMETRY_PERIOD);
+}
+
+//-----------------------------------------------------------------
+// The full mirror forwards ESP32 bytes to UCA1 as they come, so a
+// line can stall part way and have a frame sent after it. Whole
+// command lines are all the mirror sends while the frames run; it
+// stays that way after ^0000T0 until ^0000M1.
+//-----------------------------------------------------------------
+void telemetry_set_period(unsigned long period){
+    if(period > SWT_MAX_MS){
+        period = SWT_MAX_MS;            // Longest the timer can count at this TICK_MS
+    }
+    telemetry_period = period;
+    if(period && bridge_mode == MIRROR_FULL){
+        bridge_set_mode(MIRROR_FILTERED);
+    }
+    if(period){
+        swt_start(&telemetry_timer, MS_TO_TICKS(period), MS_TO_TICKS(period));
+    } else {
+        swt_cancel(&telemetry_timer);
+    }
+}
+
+unsigned int crc16(const unsigned char *data, unsigned int length, unsigned int crc){
+    while(length--){
+        crc ^= (unsigned int)*data++ << 8;
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) & 0x0F];
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) & 0x0F];
+    }
+    return crc & 0xFFFF;
+}
+
+//-----------------------------------------------------------------
+// COBS: every 0x00 in the block is replaced by the distance to the
+// next one, so 0x00 only ever appears as the frame delimiter.
+// dest needs length + length / 254 + 2 bytes. Returns bytes written.
+//-----------------------------------------------------------------
+unsigned int cobs_encode(const unsigned char *src, unsigned int length, unsigned char *dest){
+    unsigned int code_at = 0;
+    unsigned int out = 1;
+    unsigned char code = 1;
+
+    while(length--){
+        if(*src){
+            dest[out++] = *src;
+            code++;
+        }
+        if(!*src++ || code == 0xFF){
+            dest[code_at] = code;
+            code_at = out++;
+            code = 1;
+        }
+    }
+    dest[code_at] = code;
+    dest[out++] = TLM_DELIMITER;
+    return out;
+}
+
+void put_u16(unsigned char *dest, unsigned int value){
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+}
+
+void put_u32(unsigned char *dest, unsigned long value){
+    put_u16(dest, (unsigned int)value);
+    put_u16(dest + 2, (unsigned int)(value >> 16));
+}
+
+//-----------------------------------------------------------------
+// Frame a payload and queue it on the USB UART. Never waits: returns
+// FALSE and counts a skip if both frame buffers are still going out.
+//-----------------------------------------------------------------
+char telemetry_send(unsigned char type, const unsigned char *payload, unsigned int length){
+    unsigned char raw[TLM_MAX_RAW];
+    unsigned long ms;
+    unsigned int crc;
+    unsigned int size;
+    char slot;
+
+    if(length > TLM_MAX_PAYLOAD){
+        return FALSE;
+    }
+    if(tlm_frame_done[0]){
+        slot = 0;
+    } else if(tlm_frame_done[1]){
+        slot = 1;
+    } else {
+        telemetry_skipped++;
+        return FALSE;
+    }
+
+    ms = now_ms();
+
+    raw[TLM_OFF_TYPE] = type;
+    put_u16(&raw[TLM_OFF_SEQ], telemetry_seq);
+    put_u32(&raw[TLM_OFF_TIME], ms);
+    memcpy(&raw[TLM_HEADER_LEN], payload, length);
+    length += TLM_HEADER_LEN;
+    crc = crc16(raw, length, TLM_CRC_START);
+    put_u16(&raw[length], crc);
+    length += TLM_CRC_LEN;
+
+    tlm_frame[slot][0] = TLM_DELIMITER;    // Ends any text sent before it
+    size = 1 + cobs_encode(raw, length, &tlm_frame[slot][1]);
+    if(!usb_send((const char *)tlm_frame[slot], size, &tlm_frame_done[slot])){
+        telemetry_skipped++;
+        return FALSE;
+    }
+    telemetry_seq++;
+    return TRUE;
+}
+
+// TRUE when a frame buffer is free
+char telemetry_ready(void){
+    return tlm_frame_done[0] || tlm_frame_done[1];
+}
+
+void Telemetry_Process(void){
+    unsigned char status[TLM_STATUS_LEN];
+    adc_snapshot snap;
+    unsigned long age;
+
+    isr_prof_process();                 // ISR dump in progress
+    capture_process();                  // Capture dump in progress
+    edge_process();                     // Line stop waiting to be reported
+    if(!swt_fired(&telemetry_timer)){
+        return;
+    }
+
+    adc_read(&snap);
+    put_u16(&status[TLM_ST_LEFT], snap.value[ADC_LEFT]);
+    put_u16(&status[TLM_ST_RIGHT], snap.value[ADC_RIGHT]);
+    put_u16(&status[TLM_ST_THUMB], snap.value[ADC_THUMB]);
+    status[TLM_ST_BLSTATE] = BLState;
+    status[TLM_ST_MOVEMENT] = movement;
+    put_u16(&status[TLM_ST_R_FORWARD], RIGHT_FORWARD_SPEED);
+    put_u16(&status[TLM_ST_R_REVERSE], RIGHT_REVERSE_SPEED);
+    put_u16(&status[TLM_ST_L_FORWARD], LEFT_FORWARD_SPEED);
+    put_u16(&status[TLM_ST_L_REVERSE], LEFT_REVERSE_SPEED);
+    put_u16(&status[TLM_ST_IOT_HIGH], iot_rx_ring.high_water);
+    put_u16(&status[TLM_ST_IOT_OVERRUN], iot_rx_ring.overrun);
+    put_u16(&status[TLM_ST_USB_OVERRUN], usb_rx_ring.overrun);
+    put_u16(&status[TLM_ST_BRIDGE_DROP], iot_to_usb.dropped + usb_to_iot.dropped);
+    put_u16(&status[TLM_ST_SKIPPED], telemetry_skipped);
+    put_u16(&status[TLM_ST_MOTION_QUEUE], motion_pending());
+    put_u16(&status[TLM_ST_MOTION_OVER], motion_overflow);
+    put_u16(&status[TLM_ST_BOOT_MS], iot_boot_ms);
+    power_status(status);
+    put_u16(&status[TLM_ST_ADC_MISSED], adc_missed);
+    age = US_SINCE(snap.stamp[ADC_LEFT]);
+    put_u16(&status[TLM_ST_LINE_AGE], age < 0xFFFF ? age : 0xFFFF);
+    put_u16(&status[TLM_ST_FILTER_MAX], adc_filter_worst);
+    adc_filter_worst = 0;
+    put_u16(&status[TLM_ST_AMB_LEFT], snap.ambient[ADC_LEFT]);
+    put_u16(&status[TLM_ST_AMB_RIGHT], snap.ambient[ADC_RIGHT]);
+    status[TLM_ST_IR_MODE] = adc_ir_mode;
+    put_u16(&status[TLM_ST_BAT_MV], rail_mv[RAIL_BAT]);
+    status[TLM_ST_BAT_LOW] = bat_low;
+
+    telemetry_send(TLM_TYPE_STATUS, status, TLM_STATUS_LEN);
+}
@@ -0,0 +1,172 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Binary telemetry frames sent on the USB UART (UCA1). Shared with the
+ *  host decoder in tools/, so it only holds plain macros.
+ *
+ *  On the wire every frame is COBS encoded and sent between two 0x00
+ *  bytes. UCA1 also carries text: USB command replies, and mirrored
+ *  command lines, which are whole lines while telemetry is on. Text
+ *  never holds a 0x00, so it always arrives as a block of its own.
+ *  Decoded, a frame is
+ *
+ *    type (1) | sequence (2) | time ms (4) | payload (n) | CRC-16 (2)
+ *
+ *  Multi-byte fields are little endian. The CRC is CRC-16/CCITT-FALSE
+ *  (poly 0x1021, start 0xFFFF) over everything before it.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#define TLM_DELIMITER       (0x00)
+#define TLM_HEADER_LEN      (7)
+#define TLM_CRC_LEN         (2)
+#define TLM_MAX_PAYLOAD     (96)
+#define TLM_MAX_RAW         (TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN)
+#define TLM_MAX_FRAME       (TLM_MAX_RAW + (TLM_MAX_RAW / 254) + 3)   // With both delimiters
+#define TLM_CRC_START       (0xFFFF)
+
+// Header offsets
+#define TLM_OFF_TYPE        (0)
+#define TLM_OFF_SEQ         (1)
+#define TLM_OFF_TIME        (3)
+
+// Frame types
+#define TLM_TYPE_STATUS     (0x01)
+#define TLM_TYPE_LATENCY    (0x02)
+#define TLM_TYPE_TASKS      (0x03)
+#define TLM_TYPE_ISR        (0x04)
+#define TLM_TYPE_BATTERY    (0x05)
+#define TLM_TYPE_CAPTURE    (0x06)
+#define TLM_TYPE_EDGE       (0x07)
+
+//------------------------------------------------------------------------------
+// Status frame payload, offsets from the start of the payload
+//------------------------------------------------------------------------------
+#define TLM_ST_LEFT         (0)     // Left detector, filtered, 14 bit
+#define TLM_ST_RIGHT        (2)     // Right detector, filtered, 14 bit
+#define TLM_ST_THUMB        (4)     // Thumbwheel, filtered, 14 bit
+#define TLM_ST_BLSTATE      (6)     // BLState
+#define TLM_ST_MOVEMENT     (7)     // movement
+#define TLM_ST_R_FORWARD    (8)     // TB3CCR2
+#define TLM_ST_R_REVERSE    (10)    // TB3CCR3
+#define TLM_ST_L_FORWARD    (12)    // TB3CCR4
+#define TLM_ST_L_REVERSE    (14)    // TB3CCR5
+#define TLM_ST_IOT_HIGH     (16)    // iot_rx_ring high water
+#define TLM_ST_IOT_OVERRUN  (18)    // iot_rx_ring overrun
+#define TLM_ST_USB_OVERRUN  (20)    // usb_rx_ring overrun
+#define TLM_ST_BRIDGE_DROP  (22)    // Bytes dropped by both bridge paths
+#define TLM_ST_SKIPPED      (24)    // Frames skipped, transmitter busy
+#define TLM_ST_MOTION_QUEUE (26)    // Moves waiting in the motion queue
+#define TLM_ST_MOTION_OVER  (28)    // Moves refused, motion queue full
+#define TLM_ST_BOOT_MS      (30)    // ESP32 boot time, 0 = still booting
+#define TLM_ST_SLEEP        (32)    // Permille of the time asleep since the last frame
+#define TLM_ST_WAKE_AVG     (34)    // us from the waking ISR to the main loop
+#define TLM_ST_WAKE_MAX     (36)    // us, worst since the last frame
+#define TLM_ST_ADC_MISSED   (38)    // ADC conversions lost since reset
+#define TLM_ST_LINE_AGE     (40)    // us since the left detector was sampled
+#define TLM_ST_FILTER_MAX   (42)    // us, longest ADC filter run since the last frame
+#define TLM_ST_AMB_LEFT     (44)    // Ambient light on the left detector, 14 bit
+#define TLM_ST_AMB_RIGHT    (46)    // Ambient light on the right detector, 14 bit
+#define TLM_ST_IR_MODE      (48)    // adc_ir_mode, ADC_IR_...
+#define TLM_ST_BAT_MV       (49)    // V_BAT in mV
+#define TLM_ST_BAT_LOW      (51)    // bat_low
+#define TLM_STATUS_LEN      (52)
+
+//------------------------------------------------------------------------------
+// Latency frame payload, sent by ^0000K2. Two sets of statistics, times in us
+//------------------------------------------------------------------------------
+#define TLM_LAT_TOTAL       (0)     // '^' received to command applied
+#define TLM_LAT_PARSE       (26)    // '^' received to command parsed
+#define TLM_LAT_LOST        (52)    // '^' not stamped, stamp FIFO full
+#define TLM_LATENCY_LEN     (54)
+
+// Offsets inside each set
+#define TLM_LS_COUNT        (0)
+#define TLM_LS_MIN          (2)
+#define TLM_LS_AVG          (6)
+#define TLM_LS_MAX          (10)
+#define TLM_LS_P50          (14)
+#define TLM_LS_P95          (18)
+#define TLM_LS_P99          (22)
+
+//------------------------------------------------------------------------------
+// Task frame payload, sent by ^0000K3. One entry per scheduler task, in
+// the order of the task table in scheduler.c
+//------------------------------------------------------------------------------
+#define TLM_TASK_LEN        (12)
+#define TLM_TASKS_MAX       (TLM_MAX_PAYLOAD / TLM_TASK_LEN)
+#define TLM_TK_RUNS         (0)
+#define TLM_TK_AVG          (4)     // us
+#define TLM_TK_WORST        (6)     // us
+#define TLM_TK_OVERRUNS     (8)     // Runs longer than the task's budget
+#define TLM_TK_LATE         (10)    // Releases missed
+
+//------------------------------------------------------------------------------
+// ISR frame payload, sent by ^0000K4 once per ISR when ISR_PROFILE is
+// built in. Times in us, histograms are 16 counts each: run time in 8 us
+// buckets, time since the previous entry in 1024 us buckets. The last
+// bucket holds everything longer.
+//------------------------------------------------------------------------------
+#define TLM_IS_ID           (0)     // ISR_PROF_* in isrprof.h, 1 byte + 1 spare
+#define TLM_IS_COUNT        (2)
+#define TLM_IS_WORST        (4)
+#define TLM_IS_NESTED       (6)
+#define TLM_IS_LATE         (8)     // Timer ISRs only
+#define TLM_IS_DURATION     (10)
+#define TLM_IS_INTERVAL     (42)
+#define TLM_ISR_LEN         (74)
+
+//------------------------------------------------------------------------------
+// Battery frame payload, sent when the battery goes low or recovers
+//------------------------------------------------------------------------------
+#define TLM_BAT_MV          (0)     // V_BAT, mV
+#define TLM_BAT_5_0         (2)     // V_5_0, mV
+#define TLM_BAT_3_3         (4)     // V_3_3, mV
+#define TLM_BAT_LOW         (6)     // 1 = low
+#define TLM_BAT_COMP        (7)     // Duty scale in 1/1024ths
+#define TLM_BATTERY_LEN     (9)
+
+//------------------------------------------------------------------------------
+// Capture frame payload, a run of records from a raw ADC capture
+// (capture.h). Every frame repeats the header so each one can be placed
+// on its own. Record i was taken the slots of records pre + 1 to i times
+// slot_us after the trigger record, which is record pre.
+//------------------------------------------------------------------------------
+#define TLM_CAP_ID          (0)     // Capture number, 1 byte
+#define TLM_CAP_SOURCE      (1)     // ADC_LEFT, ADC_RIGHT or 0xFF manual
+#define TLM_CAP_FIRST       (2)     // Index of the first record in this frame
+#define TLM_CAP_TOTAL       (4)     // Records in the capture
+#define TLM_CAP_PRE         (6)     // Records before the trigger
+#define TLM_CAP_SLOT_US     (8)     // us per ADC slot
+#define TLM_CAP_LEVEL       (10)    // Trigger level, raw 12 bit, 0 manual
+#define TLM_CAP_TRIG_US     (12)    // now_us() of the trigger record
+#define TLM_CAP_RECORDS     (16)
+#define TLM_CAP_REC_LEN     (6)
+#define TLM_CAP_PER_FRAME   ((TLM_MAX_PAYLOAD - TLM_CAP_RECORDS) / TLM_CAP_REC_LEN)
+
+// Offsets inside each record, raw 12 bit conversions
+#define TLM_CR_LEFT         (0)     // Bits 15-12: ADC slots since the record before
+#define TLM_CR_RIGHT        (2)     // Bit 15: emitter off
+#define TLM_CR_THUMB        (4)
+
+//------------------------------------------------------------------------------
+// Edge frame payload, sent each time the line state machine stops on the
+// line (edge.h). Latencies are us from the detector sample to the brake.
+//------------------------------------------------------------------------------
+#define TLM_ED_SOURCE       (0)     // 0 braked by ADC_ISR, 1 by the main loop
+#define TLM_ED_DETECTOR     (1)     // ADC_LEFT or ADC_RIGHT, 0xFF no crossing seen
+#define TLM_ED_LATENCY      (2)     // This stop, 0xFFFF unknown
+#define TLM_ED_SAMPLE_US    (4)     // now_us() of the sample that crossed
+#define TLM_ED_BRAKES       (8)     // Stops made by ADC_ISR since reset
+#define TLM_ED_MIN          (10)    // Best and worst ADC_ISR latency
+#define TLM_ED_MAX          (12)
+#define TLM_ED_CROSS_L      (14)    // Crossings onto the line since reset
+#define TLM_ED_CROSS_R      (16)
+#define TLM_EDGE_LEN        (18)
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,75 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file gives the program one time base that does not run out.
+ *  Timer B0 counts at 1 MHz, so TB0R is in microseconds and wraps every
+ *  65.5 ms. TIMER0_B1_ISR counts the wraps in tb0_overflows, which
+ *  makes now_us() a 32 bit count of microseconds (71 minutes before it
+ *  wraps). now_ms() is built from system_ticks, good for 49 days.
+ *
+ *  Both are read with interrupts off, and look at the timer's pending
+ *  flag in case the counter has just wrapped but the ISR has not run
+ *  yet, so a value is never torn between the old and new high part.
+ *  The interrupt state is restored rather than enabled, so they can
+ *  be called from an ISR.
+ *
+ *  Compare times with TIME_SINCE / TIME_REACHED in timebase.h, which
+ *  stay right across a wrap.
+ *
+ *  Functions included:
+ *    - now_us: Microseconds since Timer B0 started.
+ *    - now_ms: Milliseconds since Timer B0 started.
+ *
+ */
+
+
+#include "msp430.h"
+#include "functions.h"
+#include "macros.h"
+#include "timebase.h"
+
+extern volatile unsigned long system_ticks;
+
+volatile unsigned int tb0_overflows;    // TB0R wraps, counted by TIMER0_B1_ISR
+
+unsigned long now_us(void){
+    unsigned int state = __get_interrupt_state();
+    unsigned int high;
+    unsigned int low;
+
+    __disable_interrupt();
+    high = tb0_overflows;
+    low = TB0R;
+    if((TB0CTL & TBIFG) && low < 0x8000){
+        high++;                         // Wrapped, not counted yet
+    }
+    __set_interrupt_state(state);
+    return ((unsigned long)high << 16) | low;
+}
+
+//-----------------------------------------------------------------
+// TB0CCR0 is the next tick, so the current one started
+// TB0_TICK_US before it. Not for use in Timer0_B0_ISR before it has
+// moved TB0CCR0 on.
+//-----------------------------------------------------------------
+unsigned long now_ms(void){
+    unsigned int state = __get_interrupt_state();
+    unsigned long ticks;
+    unsigned int into;                  // us since the tick started
+
+    __disable_interrupt();
+    ticks = system_ticks;
+    if(TB0CCTL0 & CCIFG){
+        ticks++;                        // Tick due, not counted yet
+        into = TB0R - TB0CCR0;
+    } else {
+        into = TB0R - (TB0CCR0 - TB0_TICK_US);
+    }
+    __set_interrupt_state(state);
+    return ticks * (TB0_TICK_US / 1000) + into / 1000;
+}
@@ -0,0 +1,60 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Monotonic time for the whole program. now_us() is Timer B0's count
+ *  (1 MHz) extended by its overflows, now_ms() is the system tick plus
+ *  the part of the current tick. Both are 32 bit and can be read from
+ *  the main loop or an ISR.
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+//------------------------------------------------------------------------------
+// Timer B0 runs at 1 MHz whatever MCLK_FREQ_MHZ is (SMCLK = MCLK). The
+// divide is ID x IDEX, ID being 1, 2, 4 or 8 and IDEX 1 to 8. The tick is
+// TICK_MS (macros.h), one CCR0 step of TB0_TICK_US counts.
+//------------------------------------------------------------------------------
+#if MCLK_FREQ_MHZ <= 8
+#define TB0_ID_DIV          (1)
+#define TB0_ID              (ID__1)
+#elif MCLK_FREQ_MHZ <= 16
+#define TB0_ID_DIV          (2)
+#define TB0_ID              (ID__2)
+#elif MCLK_FREQ_MHZ <= 32
+#define TB0_ID_DIV          (4)
+#define TB0_ID              (ID__4)
+#else
+#define TB0_ID_DIV          (8)
+#define TB0_ID              (ID__8)
+#endif
+#define TB0_IDEX_DIV        (MCLK_FREQ_MHZ / TB0_ID_DIV)
+#define TB0_IDEX            (TB0_IDEX_DIV - 1)          // TBIDEX__n is n - 1
+#define TB0_TICK_US         (TICK_MS * 1000UL)          // Counts between CCR0 interrupts
+
+#if MCLK_FREQ_MHZ % TB0_ID_DIV || TB0_IDEX_DIV < 1 || TB0_IDEX_DIV > 8
+#error "Timer B0 cannot divide MCLK_FREQ_MHZ down to 1 MHz"
+#endif
+#if TICK_MS < 1 || TB0_TICK_US > 65535
+#error "TICK_MS must be 1 to 65 ms, one CCR0 step of Timer B0"
+#endif
+
+extern volatile unsigned int tb0_overflows;
+
+unsigned long now_us(void);
+unsigned long now_ms(void);
+
+//------------------------------------------------------------------------------
+// Wrap-safe elapsed time and deadlines. Correct while the times compared
+// are less than 2^31 units apart: 35 minutes for now_us, 24 days for
+// now_ms.
+//------------------------------------------------------------------------------
+#define TIME_SINCE(now, start)      ((unsigned long)((now) - (start)))
+#define TIME_REACHED(now, deadline) ((long)((now) - (deadline)) >= 0)
+#define US_SINCE(start)             TIME_SINCE(now_us(), (start))
+#define MS_SINCE(start)             TIME_SINCE(now_ms(), (start))
+
+#endif /* TIMEBASE_H_ */
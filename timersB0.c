@@ -8,15 +8,18 @@
  *  ------------
  *  This file contains timer initialization and interrupt service routines
  *  for the MSP430. It sets up Timer B0 for periodic interrupts used for
- *  timing, debouncing switches, and managing system counters. It also
+ *  timing and debouncing switches. Modules keep their own timeouts as
+ *  software timers (swtimer.c) that the TICK_MS tick runs. It also
  *  configures Timer B3 for PWM generation to control motor speeds and
- *  backlight brightness.
+ *  backlight brightness. Timer B1 only drives TB1.1, which starts an
+ *  ADC conversion on every period (adc.c).
  *
  *  Functions included:
- *    - Init_Timers: Initializes both Timer B0 and Timer B3.
+ *    - Init_Timers: Initializes Timer B0, Timer B1 and Timer B3.
  *    - Init_Timer_B0: Configures Timer B0 for timing and debounce interrupts.
- *    - Timer0_B0_ISR: Handles periodic tasks every 10 ms.
- *    - TIMER0_B1_ISR: Handles switch debounce and overflow events.
+ *    - Timer0_B0_ISR: Counts the TICK_MS tick and runs the software timers.
+ *    - TIMER0_B1_ISR: Handles switch debounce and counts TB0R overflows.
+ *    - Init_Timer_B1: Sets up TB1.1 as the ADC conversion trigger.
  *    - Init_Timer_B3: Sets up PWM outputs for motor and backlight control.
  *
  */
@@ -28,32 +31,30 @@
 #include  "LCD.h"
 #include  "ports.h"
 #include "macros.h"
+#include "power.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "adc.h"
+#include "isrprof.h"
 
-extern volatile unsigned int wait;
 extern volatile unsigned int proj7timer;
 extern volatile unsigned int proj7timer2;
-extern volatile unsigned int proj8timer;
-extern volatile unsigned int proj8display;
 volatile unsigned char update_display;
 volatile unsigned int Time_Sequence;
 volatile unsigned int time_change;
 volatile unsigned int start_instruction;
 volatile unsigned int instruction;
-volatile unsigned int count_debounce_SW1;
-volatile unsigned int count_debounce_SW2;
 volatile unsigned int hex;
 volatile unsigned int counter;
 volatile unsigned int overflow_ctr;
 volatile unsigned int DAC_data;
 
 
-extern unsigned int iot_boot_timer;
-extern unsigned int time;
-volatile unsigned int timer10s;
-volatile unsigned int tenmsCounter;
+volatile unsigned long system_ticks;
 
 void Init_Timers(void){
     Init_Timer_B0();
+    Init_Timer_B1();
     Init_Timer_B3();
 }
 
@@ -63,54 +64,45 @@ void Init_Timer_B0(void) {
     TB0CTL = TBSSEL__SMCLK;         // SMCLK source
     TB0CTL |= TBCLR;                // Resets TB0R, clock divider, count direction
     TB0CTL |= MC__CONTINOUS;        // Continuous up
-    TB0CTL |= ID__2;                // Divide clock by 2
+    TB0CTL |= TB0_ID;               // 1 MHz, TB0R counts microseconds
 
-    TB0EX0 = TBIDEX__8; // Divide clock by an additional 8
+    TB0EX0 = TB0_IDEX;              // Rest of the divide, see timebase.h
 
 
-    TB0CCR0 = TB0CCR0_INTERVAL;     // CCR0
+    TB0CCR0 = TB0_TICK_US;          // CCR0, one tick
     TB0CCTL0 |= CCIE;               // CCR0 enable interrupt
     // TB0CCR1 = TB0CCR1_INTERVAL; // CCR1
     // TB0CCTL1 |= CCIE; // CCR1 enable interrupt
     // TB0CCR2 = TB0CCR2_INTERVAL; // CCR2
     // TB0CCTL2 |= CCIE; // CCR2 enable interrupt
-    TB0CTL &= ~TBIE;     // Disable Overflow Interrupt
     TB0CTL &= ~TBIFG;   // Clear Overflow Interrupt flag
+    TB0CTL |= TBIE;      // Overflow Interrupt extends TB0R, see timebase.c
 
 }
 //------------------------------------------------------------------------------
 
 #pragma vector = TIMER0_B0_VECTOR
 __interrupt void Timer0_B0_ISR(void){
+    ISR_PROF_ENTER(ISR_PROF_TB0_0);
+    ISR_PROF_LATE(ISR_PROF_TB0_0, TB0CCR0);
 //------------------------------------------------------------------------------
 // TimerB0 0 Interrupt handler
 //----------------------------------------------------------------------------
 //...... Add What you need happen in the interrupt ......
-    // Interrupt runs every 10 ms
+    // Interrupt runs every TICK_MS
 
-    iot_boot_timer++;
-    time++;
-
-    proj8timer++;
-    proj8display++;
-    tenmsCounter++;
-    timer10s++;
-    wait++;
-
-    if(count_debounce_SW1){
-        count_debounce_SW1--;
-    }
-
-    if(count_debounce_SW2){
-        count_debounce_SW2--;
-    }
+    system_ticks++;
+    swt_tick();                  // Software timers, see swtimer.c
     update_display = 1;
-    TB0CCR0 += TB0CCR0_INTERVAL; // Add Offset to TBCCR0
+    TB0CCR0 += TB0_TICK_US;      // Add Offset to TBCCR0
+    POWER_WAKE();                // Timed tasks may be due
+    ISR_PROF_EXIT(ISR_PROF_TB0_0);
 //----------------------------------------------------------------------------
 }
 
 #pragma vector = TIMER0_B1_VECTOR
 __interrupt void TIMER0_B1_ISR(void){
+    ISR_PROF_ENTER(ISR_PROF_TB0_1);
     //----------------------------------------------------------------------------
     // TimerB0 1-2, Overflow Interrupt Vector (TBIV) handler
     //----------------------------------------------------------------------------
@@ -131,14 +123,33 @@ __interrupt void TIMER0_B1_ISR(void){
             TB0CCR2 += TB0CCR2_INTERVAL; // Add Offset to TBCCR2
             break;
         case 14: // overflow
-            //...... Add What you need happen in the interrupt ......
+            tb0_overflows++;
             break;
         default: break;
 }
+    ISR_PROF_EXIT(ISR_PROF_TB0_1);
 //----------------------------------------------------------------------------
 }
 
 
+//------------------------------------------------------------------------------
+// Timer B1: 1 MHz up mode, period ADC_SLOT_US. TB1.1 is reset halfway
+// and set again at the end of every period, the rising edge is the
+// ADC's sample-and-hold trigger (ADCSHS_1). No interrupts.
+//------------------------------------------------------------------------------
+void Init_Timer_B1(void) {
+    TB1CTL = TBSSEL__SMCLK;         // SMCLK source
+    TB1CTL |= TBCLR;                // Resets TB1R, clock divider, count direction
+    TB1CTL |= TB0_ID;               // Same dividers as TB0, TB1R counts microseconds
+    TB1EX0 = TB0_IDEX;
+
+    TB1CCR0 = ADC_SLOT_US - 1;      // Period
+    TB1CCTL1 = OUTMOD_7;            // CCR1 reset/set
+    TB1CCR1 = ADC_SLOT_US / 2;
+    TB1CTL |= MC__UP;               // Up Mode
+}
+
+
 void Init_Timer_B3(void) {
     //------------------------------------------------------------------------------
     // SMCLK source, up count mode, PWM Right Side
@@ -0,0 +1,156 @@
+/*
+ * adc_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host test for the detector path of adc.c, built from the firmware
+ *  source against shim/msp430.h. ADC_ISR is called once per slot with
+ *  ADCMEM0 set to what the channel being converted would read: the
+ *  detectors read one value with the IR emitter (P2.2) lit and a
+ *  higher one in the dark, the thumbwheel and rails a fixed value.
+ *
+ *  For each IR mode, ADC_IR_OFF, ADC_IR_ON and ADC_IR_SYNC, it checks
+ *  that both detectors keep publishing (their stamps in adc_read()
+ *  stay recent) and that the values are the ones the mode promises:
+ *
+ *    OFF   the dark reading, ambient full scale less it
+ *    ON    the lit reading, no ambient
+ *    SYNC  full scale less what the emitter pulled the reading down
+ *          by, ambient from the dark half
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -Wno-unknown-pragmas -Ishim -I.. -o adc_test adc_test.c ../adc.c
+ *    ./adc_test
+ *
+ *  Functions included:
+ *    - now_us ... __bic_SR_register_on_exit: What adc.c uses from the
+ *      rest of the firmware.
+ *    - run: Converts <slots> slots.
+ *    - check_mode: Runs one IR mode and checks the detectors.
+ *    - main: Checks every mode and prints the failures.
+ *
+ */
+
+
+#include <stdio.h>
+#include "msp430.h"
+#include "macros.h"
+#include "timebase.h"
+#include "adc.h"
+
+#define SLOTS_PER_MODE  (2000)
+#define STALE_SLOTS     (16)        // A detector publishes every 8 or so
+#define OTHER_READING   (2000)
+#define IR_LED          (0x04)      // P2.2, as in ports.h
+
+extern unsigned int ADC_Channel;
+extern volatile unsigned char adc_ir_mode;
+
+void Init_ADC(void);
+void IR_LED_control(char selection);
+void ADC_ISR(void);
+
+volatile unsigned short ADCCTL0, ADCCTL1, ADCCTL2, ADCMCTL0, ADCMEM0;
+volatile unsigned short ADCHI, ADCLO, ADCIE, ADCIV;
+volatile unsigned short TB0R, TB1CCR0, TB1CCR1;
+volatile unsigned char P2OUT;
+volatile unsigned char power_asleep;
+volatile unsigned int power_wake_at;
+
+static const unsigned int lit_reading[ADC_DETECTORS] = {900, 1400};
+static const unsigned int dark_reading[ADC_DETECTORS] = {3100, 3300};
+static unsigned long slot_us;
+static unsigned int failures;
+
+unsigned long now_us(void){
+    return slot_us;
+}
+
+void capture_sample(unsigned char channel, unsigned int result, unsigned char off){
+    (void)channel; (void)result; (void)off;
+}
+
+void edge_window(unsigned char channel, unsigned char off, unsigned int ambient){
+    (void)channel; (void)off; (void)ambient;
+}
+
+void edge_crossing(char high){
+    (void)high;
+}
+
+void __bic_SR_register_on_exit(unsigned int bits){
+    (void)bits;
+}
+
+static void run(unsigned int slots){
+    unsigned int channel;
+
+    while(slots--){
+        slot_us += ADC_SLOT_US;
+        channel = ADC_Channel;
+        if(channel < ADC_DETECTORS){
+            ADCMEM0 = (P2OUT & IR_LED) ? lit_reading[channel] : dark_reading[channel];
+        } else {
+            ADCMEM0 = OTHER_READING;
+        }
+        ADCIV = ADCIV_ADCIFG;
+        ADC_ISR();
+    }
+}
+
+static void check_mode(char mode, const char *name){
+    adc_snapshot snap;
+    unsigned int value;
+    unsigned int ambient;
+    unsigned char i;
+
+    IR_LED_control(mode);
+    run(SLOTS_PER_MODE);
+    adc_read(&snap);
+    if(adc_ir_mode != mode){
+        printf("FAIL: %s, mode not taken up\n", name);
+        failures++;
+        return;
+    }
+    for(i = 0; i < ADC_DETECTORS; i++){
+        if(mode == ADC_IR_OFF){
+            value = dark_reading[i] << 2;
+            ambient = ADC_SNAP_FULL - value;
+        } else if(mode == ADC_IR_ON){
+            value = lit_reading[i] << 2;
+            ambient = 0;
+        } else {
+            value = ADC_SNAP_FULL - ((dark_reading[i] - lit_reading[i]) << 2);
+            ambient = ADC_SNAP_FULL - (dark_reading[i] << 2);
+        }
+        if(slot_us - snap.stamp[i] > STALE_SLOTS * ADC_SLOT_US){
+            printf("FAIL: %s, detector %u last published %lu us ago\n",
+                   name, i, slot_us - snap.stamp[i]);
+            failures++;
+        } else if(snap.value[i] != value || snap.ambient[i] != ambient){
+            printf("FAIL: %s, detector %u value %u ambient %u, expected %u %u\n",
+                   name, i, snap.value[i], snap.ambient[i], value, ambient);
+            failures++;
+        }
+    }
+}
+
+int main(void){
+    Init_ADC();
+    run(SLOTS_PER_MODE);                // ADC_IR_DEFAULT
+
+    check_mode(ADC_IR_OFF, "IR off");
+    check_mode(ADC_IR_ON, "IR on");
+    check_mode(ADC_IR_SYNC, "IR sync");
+    check_mode(ADC_IR_OFF, "IR off after sync");
+
+    if(failures){
+        printf("%u failed\n", failures);
+        return 1;
+    }
+    printf("detectors publish in every IR mode\n");
+    return 0;
+}
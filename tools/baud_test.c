@@ -0,0 +1,149 @@
+/*
+ * baud_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host test for the baud rate divisors in baud.h. It builds the same
+ *  baud_table as serial.c from the same SMCLK_FREQ and checks:
+ *
+ *    - the UCAxBRW and UCAxMCTLW values against ones worked out by hand
+ *      from the user's guide procedure for SMCLK = 8 MHz,
+ *    - that every rate passes the BAUD_MAX_ERROR check serial.c makes,
+ *    - that every rate is in tolerance when a character is timed clock
+ *      by clock, with UCBRSx stretching bits LSB first from the start
+ *      bit. The edge of each bit is compared with where it should be;
+ *      the worst one has to be within BAUD_EDGE_LIMIT of a bit, which
+ *      leaves the receiver most of its half bit of sampling margin.
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -I.. -o baud_test baud_test.c
+ *    ./baud_test
+ *
+ *  Functions included:
+ *    - edge_error: Worst bit edge error of one character, in %.
+ *    - main: Runs the checks and prints the table.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "macros.h"
+#include "baud.h"
+
+#define CHARACTER_BITS  (10)    // Start, 8 data, stop
+#define BAUD_EDGE_LIMIT (15.0)  // % of a bit
+
+static const baud_setting baud_table[BAUD_COUNT] = {
+    BAUD_ENTRY(9600),
+    BAUD_ENTRY(19200),
+    BAUD_ENTRY(38400),
+    BAUD_ENTRY(57600),
+    BAUD_ENTRY(115200),
+    BAUD_ENTRY(230400),
+    BAUD_ENTRY(460800),
+    BAUD_ENTRY(921600)
+};
+
+static const unsigned long average_error[BAUD_COUNT] = {
+    BAUD_ERROR(9600),
+    BAUD_ERROR(19200),
+    BAUD_ERROR(38400),
+    BAUD_ERROR(57600),
+    BAUD_ERROR(115200),
+    BAUD_ERROR(230400),
+    BAUD_ERROR(460800),
+    BAUD_ERROR(921600)
+};
+
+// Worked by hand for SMCLK = 8 MHz, see the header of baud.h
+static const struct {
+    unsigned char speed;
+    unsigned int brw;
+    unsigned int mctlw;
+} expected[] = {
+    {BAUD_9600,   52, 0x2511},      // N = 833.33, UCBRF 1, fraction .3333
+    {BAUD_115200,  4, 0x5551},      // N = 69.44, UCBRF 5, fraction .4444
+    {BAUD_921600,  8, 0xD600}       // N = 8.68, no oversampling, fraction .6806
+};
+
+//-----------------------------------------------------------------
+// Clocks per bit are UCBRx (times 16 plus UCBRFx when oversampling)
+// plus one when the UCBRSx bit for that bit is set.
+//-----------------------------------------------------------------
+static double edge_error(const baud_setting *setting){
+    unsigned int brs = setting->mctlw >> 8;
+    unsigned int base;
+    double ideal = (double)SMCLK_FREQ / setting->baud;
+    double worst = 0;
+    double error;
+    unsigned long clocks = 0;
+    unsigned int bit;
+
+    if(setting->mctlw & BAUD_OS16_BIT){
+        base = setting->brw * 16 + ((setting->mctlw >> 4) & 0x0F);
+    } else {
+        base = setting->brw;
+    }
+    for(bit = 0; bit < CHARACTER_BITS; bit++){
+        clocks += base + ((brs >> (bit % 8)) & 1);
+        error = (clocks - ideal * (bit + 1)) / ideal * 100.0;
+        if(error < 0){
+            error = -error;
+        }
+        if(error > worst){
+            worst = error;
+        }
+    }
+    return worst;
+}
+
+int main(void){
+    unsigned int failures = 0;
+    unsigned int i;
+    double edge;
+
+    if(SMCLK_FREQ != 8000000UL){
+        printf("expected values are for SMCLK 8 MHz, skipping them\n");
+    } else {
+        for(i = 0; i < sizeof(expected) / sizeof(expected[0]); i++){
+            const baud_setting *setting = &baud_table[expected[i].speed];
+
+            if(setting->brw != expected[i].brw || setting->mctlw != expected[i].mctlw){
+                printf("FAIL: %lu baud BRW %u MCTLW 0x%04X, expected %u 0x%04X\n",
+                       setting->baud, setting->brw, setting->mctlw,
+                       expected[i].brw, expected[i].mctlw);
+                failures++;
+            }
+        }
+    }
+
+    printf("   baud   BRW  MCTLW  average  worst edge\n");
+    for(i = 0; i < BAUD_COUNT; i++){
+        edge = edge_error(&baud_table[i]);
+        printf("%7lu  %4u  0x%04X  %5.2f%%  %6.2f%%\n", baud_table[i].baud,
+               baud_table[i].brw, baud_table[i].mctlw, average_error[i] / 100.0, edge);
+        if(average_error[i] > BAUD_MAX_ERROR){
+            printf("FAIL: %lu baud average error over BAUD_MAX_ERROR\n", baud_table[i].baud);
+            failures++;
+        }
+        if(edge > BAUD_EDGE_LIMIT){
+            printf("FAIL: %lu baud bit edge error over %.1f%%\n", baud_table[i].baud, BAUD_EDGE_LIMIT);
+            failures++;
+        }
+        if(strncmp(baud_table[i].at_command, "AT+UART_CUR=", 12) != 0){
+            printf("FAIL: %lu baud AT command\n", baud_table[i].baud);
+            failures++;
+        }
+    }
+
+    if(failures){
+        printf("%u failed\n", failures);
+        return 1;
+    }
+    printf("baud tests passed\n");
+    return 0;
+}
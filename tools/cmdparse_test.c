@@ -0,0 +1,133 @@
+/*
+ * cmdparse_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host test for cmdparse.c, built from the firmware source. The table
+ *  here has entries shaped like the ones in commands.c (a scaled move
+ *  with an optional speed, a plain opcode, a small numeric setting)
+ *  plus a signed one, and each case checks the result code and, for
+ *  the good ones, the opcode, '!' flag and scaled arguments.
+ *
+ *  Covered: valid commands, truncated ones (key, opcode or arguments
+ *  cut short), a wrong PIN, and overlong ones (too many digits, values
+ *  over the entry's limit, text after the last argument).
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -I.. -o cmdparse_test cmdparse_test.c ../cmdparse.c
+ *    ./cmdparse_test
+ *
+ *  Functions included:
+ *    - handler: Table entry target, never called by the parser.
+ *    - main: Runs every case and prints the failures.
+ *
+ */
+
+
+#include <stdio.h>
+#include "macros.h"
+#include "cmdparse.h"
+
+#define KEY         "1234"
+#define SCALE       (25)
+#define REFUSED(command, result)    {command, result, 0, FALSE, 0, 0, 0}
+
+static void handler(const cmd_args *args){
+    (void)args;
+}
+
+static const cmd_entry table[CMD_TABLE_SIZE] = {
+    [CMD_INDEX('F')] = { handler, CMD_ARG_NUM | CMD_ARG_OPT2 | CMD_MOVE, SCALE, 9, 100 },
+    [CMD_INDEX('Q')] = { handler, CMD_ANY_LINK,                          0,     0, 0 },
+    [CMD_INDEX('M')] = { handler, CMD_ARG_NUM,                           0,     2, 0 },
+    [CMD_INDEX('O')] = { handler, CMD_ARG_NUM | CMD_ARG_SIGNED,          0,     500, 0 },
+};
+
+static const struct {
+    const char *command;
+    char result;
+    char opcode;
+    char replace;
+    char count;
+    int arg0;
+    int arg1;
+} cases[] = {
+    // Valid
+    {KEY "F5",          CMD_OK,      'F', FALSE, 1, 5 * SCALE, 0},
+    {KEY "!F5,80",      CMD_OK,      'F', TRUE,  2, 5 * SCALE, 80},
+    {KEY "F0",          CMD_OK,      'F', FALSE, 1, 0, 0},
+    {KEY "F9,100",      CMD_OK,      'F', FALSE, 2, 9 * SCALE, 100},
+    {KEY "F00009",      CMD_OK,      'F', FALSE, 1, 9 * SCALE, 0},
+    {KEY "Q",           CMD_OK,      'Q', FALSE, 0, 0, 0},
+    {KEY "M2",          CMD_OK,      'M', FALSE, 1, 2, 0},
+    {KEY "O-500",       CMD_OK,      'O', FALSE, 1, -500, 0},
+
+    // Truncated
+    REFUSED("",                CMD_BAD_KEY),
+    REFUSED("12",              CMD_BAD_KEY),
+    REFUSED(KEY,               CMD_UNKNOWN),
+    REFUSED(KEY "!",           CMD_UNKNOWN),
+    REFUSED(KEY "F",           CMD_BAD_ARG),
+    REFUSED(KEY "F5,",         CMD_BAD_ARG),
+    REFUSED(KEY "O-",          CMD_BAD_ARG),
+
+    // Bad PIN
+    REFUSED("9999F5",          CMD_BAD_KEY),
+    REFUSED("1235F5",          CMD_BAD_KEY),
+    REFUSED("F5",              CMD_BAD_KEY),
+    REFUSED("^1234F5",         CMD_BAD_KEY),
+
+    // Overlong or out of range
+    REFUSED(KEY "F123456",     CMD_BAD_ARG),
+    REFUSED(KEY "F5,123456",   CMD_BAD_ARG),
+    REFUSED(KEY "F10",         CMD_RANGE),
+    REFUSED(KEY "F5,101",      CMD_RANGE),
+    REFUSED(KEY "M3",          CMD_RANGE),
+    REFUSED(KEY "O-501",       CMD_RANGE),
+    REFUSED(KEY "F5x",         CMD_BAD_ARG),
+    REFUSED(KEY "F5,80,1",     CMD_BAD_ARG),
+    REFUSED(KEY "M1,1",        CMD_BAD_ARG),
+    REFUSED(KEY "Q1",          CMD_BAD_ARG),
+    REFUSED(KEY "M-1",         CMD_BAD_ARG),
+
+    // Unknown opcodes
+    REFUSED(KEY "X",           CMD_UNKNOWN),
+    REFUSED(KEY "f5",          CMD_UNKNOWN),
+    REFUSED(KEY "\x01",        CMD_UNKNOWN),
+};
+
+int main(void){
+    cmd_args args;
+    unsigned int failures = 0;
+    unsigned int i;
+    char result;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        result = cmd_parse(cases[i].command, KEY, table, &args);
+        if(result != cases[i].result){
+            printf("FAIL: \"%s\" gave %d, expected %d\n", cases[i].command, result, cases[i].result);
+            failures++;
+            continue;
+        }
+        if(result != CMD_OK){
+            continue;
+        }
+        if(args.opcode != cases[i].opcode || args.replace != cases[i].replace ||
+           args.count != cases[i].count || args.arg[0] != cases[i].arg0 ||
+           args.arg[1] != cases[i].arg1){
+            printf("FAIL: \"%s\" parsed as %c%s count %d args %d,%d\n", cases[i].command,
+                   args.opcode, args.replace ? " replace" : "", args.count, args.arg[0], args.arg[1]);
+            failures++;
+        }
+    }
+
+    if(failures){
+        printf("%u of %u failed\n", failures, i);
+        return 1;
+    }
+    printf("%u parser cases passed\n", i);
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+ * esp32_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host tool that stands in for the ESP32-WROOM on the IOT UART. Wire a
+ *  3.3 V USB serial adapter to the IOT connector (TX to P1.6, RX to
+ *  P1.7, ground) in place of the module, or pass -p to get a pseudo
+ *  terminal instead, and this program answers the AT commands the
+ *  firmware sends the way the AT firmware does:
+ *
+ *    AT, AT+SYSSTORE, AT+CIPMUX, AT+CIPSERVER, AT+UART_CUR  -> OK
+ *    AT+CWJAP?   -> "No AP" for the first -n tries, then the SSID
+ *    AT+CIFSR    -> station IP address
+ *    AT+CIPSEND  -> '>' prompt, reads the data, SEND OK
+ *
+ *  Every answer is delayed by -l ms plus up to -j ms of jitter, and -e
+ *  percent of them are ERROR instead. Commands are echoed like ATE1.
+ *
+ *  Once AT+CIFSR has been answered the boot time is printed and the
+ *  script given with -s is run. Script lines are
+ *
+ *    connect <link>             "<link>,CONNECT"
+ *    close <link>               "<link>,CLOSED"
+ *    send <link> <text>         "+IPD,<link>,<len>:<text>\r\n"
+ *    wait <ms>
+ *    expect <link> <text> <ms>  Wait for a reply to the link starting
+ *                               with text, print the time since the
+ *                               last send
+ *
+ *  and '#' starts a comment. Replies from the firmware are printed as
+ *  they arrive. For example, to time a status query:
+ *
+ *    connect 0
+ *    send 0 ^0000Q
+ *    expect 0 Q 1000
+ *
+ *  Build and run on Linux:
+ *    cc -O2 -o esp32_sim esp32_sim.c
+ *    ./esp32_sim -l 20 -j 10 -n 3 -s boot.txt /dev/ttyUSB1
+ *
+ *  Without the car, fw_shim runs the firmware itself on the -p pty and
+ *  prints its boot time and the command to actuation latency of every
+ *  motor change. The scripts in scenarios/ are written for that:
+ *
+ *    boot.txt      boot, then one query
+ *    latency.txt   single moves and stops, each timed on its own
+ *    burst.txt     four commands in one burst
+ *
+ *  scenarios/run.sh starts both, e.g. from tools:
+ *    scenarios/run.sh scenarios/latency.txt -l 20 -j 10
+ *
+ *  Functions included:
+ *    - now_ms: Milliseconds since the program started.
+ *    - answer: Writes a reply after the configured latency.
+ *    - at_line: Answers one AT command line.
+ *    - script_step: Runs script lines until one has to wait.
+ *    - main: Opens the port and runs the event loop.
+ *
+ */
+
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LINE_SIZE   (128)
+#define SEND_SIZE   (2048)
+
+static int fd;
+static int latency_ms;
+static int jitter_ms;
+static int error_pct;
+static int noap_count;
+static FILE *script;
+
+static struct timespec start;
+static long boot_first_at = -1;
+static long boot_done = -1;
+
+static char line[LINE_SIZE];
+static int line_len;
+
+static int send_link = -1;              // AT+CIPSEND in progress
+static int send_left;
+static char send_data[SEND_SIZE];
+static int send_len;
+
+static long last_send;                  // Time of the last script send
+static long wait_until;                 // Script paused until this time
+static int expect_link = -1;
+static char expect_text[LINE_SIZE];
+
+static long now_ms(void){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - start.tv_sec) * 1000 + (t.tv_nsec - start.tv_nsec) / 1000000;
+}
+
+static void put(const char *text){
+    if(write(fd, text, strlen(text)) < 0){
+        perror("write");
+        exit(1);
+    }
+}
+
+static void answer(const char *text){
+    int delay = latency_ms + (jitter_ms ? rand() % (jitter_ms + 1) : 0);
+
+    usleep(delay * 1000);
+    put(text);
+}
+
+static int failed(void){
+    return error_pct && rand() % 100 < error_pct;
+}
+
+static void set_raw(int baud);
+
+static void at_line(const char *cmd){
+    static int cwjap_tries;
+    int link;
+    int baud;
+
+    if(boot_first_at < 0){
+        boot_first_at = now_ms();
+    }
+    put(cmd);                           // Echo, ATE1 is the default
+    put("\r\n");
+
+    if(failed()){
+        answer("\r\nERROR\r\n");
+    } else if(sscanf(cmd, "AT+UART_CUR=%d", &baud) == 1){
+        answer("\r\nOK\r\n");
+        tcdrain(fd);
+        set_raw(baud);
+    } else if(!strcmp(cmd, "AT") || !strncmp(cmd, "AT+SYSSTORE=", 12) ||
+              !strncmp(cmd, "AT+CIPMUX=", 10) || !strncmp(cmd, "AT+CIPSERVER=", 13)){
+        answer("\r\nOK\r\n");
+    } else if(!strcmp(cmd, "AT+CWJAP?")){
+        if(cwjap_tries++ < noap_count){
+            answer("No AP\r\n\r\nOK\r\n");
+        } else {
+            answer("+CWJAP:\"SimNet\",\"02:00:00:00:00:01\",6,-48,0,1,3,0,1\r\n\r\nOK\r\n");
+        }
+    } else if(!strcmp(cmd, "AT+CIFSR")){
+        answer("+CIFSR:STAIP,\"10.154.12.130\"\r\n"
+               "+CIFSR:STAMAC,\"02:00:00:00:00:02\"\r\n\r\nOK\r\n");
+        if(boot_done < 0){
+            boot_done = now_ms();
+            printf("boot: first AT at %ld ms, AT+CIFSR answered at %ld ms\n",
+                   boot_first_at, boot_done);
+            fflush(stdout);
+        }
+    } else if(sscanf(cmd, "AT+CIPSEND=%d,%d", &link, &send_left) == 2 &&
+              send_left > 0 && send_left <= SEND_SIZE){
+        send_link = link;
+        send_len = 0;
+        answer("\r\nOK\r\n> ");
+    } else {
+        answer("\r\nERROR\r\n");
+    }
+}
+
+static void sent_data(void){
+    long t = now_ms();
+
+    printf("%6ld ms  link %d reply: %.*s", t, send_link, send_len, send_data);
+    if(send_len && send_data[send_len - 1] != '\n'){
+        printf("\n");
+    }
+    if(send_link == expect_link &&
+       !strncmp(send_data, expect_text, strlen(expect_text))){
+        printf("%6ld ms  expect %s met, %ld ms after send\n", t, expect_text, t - last_send);
+        expect_link = -1;
+        wait_until = 0;             // Carry on with the script
+    }
+    fflush(stdout);
+    answer("\r\nRecv ");
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%d bytes\r\n\r\nSEND OK\r\n", send_len);
+        put(text);
+    }
+    send_link = -1;
+}
+
+static void rx_byte(char c){
+    if(send_link >= 0){
+        send_data[send_len++] = c;
+        if(--send_left == 0){
+            sent_data();
+        }
+        return;
+    }
+    if(c == '\r'){
+        return;
+    }
+    if(c == '\n'){
+        line[line_len] = 0;
+        if(!strncmp(line, "AT", 2)){
+            at_line(line);
+        }
+        line_len = 0;
+        return;
+    }
+    if(line_len < LINE_SIZE - 1){
+        line[line_len++] = c;
+    }
+}
+
+//-----------------------------------------------------------------
+// Runs script lines until one has to wait. Returns 0 at the end of
+// the script.
+//-----------------------------------------------------------------
+static int script_step(void){
+    char text[LINE_SIZE];
+    char arg[LINE_SIZE];
+    char out[LINE_SIZE + 32];
+    int link;
+    int ms;
+
+    if(now_ms() < wait_until){
+        return 1;
+    }
+    if(expect_link >= 0){
+        printf("%6ld ms  expect %s timed out\n", now_ms(), expect_text);
+        expect_link = -1;
+    }
+    wait_until = 0;
+
+    while(fgets(text, sizeof(text), script)){
+        text[strcspn(text, "\r\n")] = 0;
+        arg[0] = 0;
+        if(text[0] == '#' || !text[0]){
+            continue;
+        } else if(sscanf(text, "connect %d", &link) == 1){
+            snprintf(out, sizeof(out), "%d,CONNECT\r\n", link);
+            put(out);
+        } else if(sscanf(text, "close %d", &link) == 1){
+            snprintf(out, sizeof(out), "%d,CLOSED\r\n", link);
+            put(out);
+        } else if(sscanf(text, "send %d %127[^\n]", &link, arg) == 2){
+            snprintf(out, sizeof(out), "+IPD,%d,%d:%s\r\n", link, (int)strlen(arg) + 2, arg);
+            last_send = now_ms();
+            put(out);
+        } else if(sscanf(text, "wait %d", &ms) == 1){
+            wait_until = now_ms() + ms;
+            return 1;
+        } else if(sscanf(text, "expect %d %127s %d", &link, expect_text, &ms) == 3){
+            expect_link = link;
+            wait_until = now_ms() + ms;
+            return 1;
+        } else {
+            fprintf(stderr, "script: can't read \"%s\"\n", text);
+        }
+    }
+    return 0;
+}
+
+static void set_raw(int baud){
+    struct termios tio;
+    speed_t speed = baud == 9600 ? B9600 : baud == 19200 ? B19200 :
+                    baud == 38400 ? B38400 : baud == 57600 ? B57600 :
+                    baud == 230400 ? B230400 : baud == 460800 ? B460800 :
+                    baud == 921600 ? B921600 : B115200;
+
+    if(tcgetattr(fd, &tio)){
+        return;                         // Not a tty, nothing to set
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+int main(int argc, char *argv[]){
+    struct pollfd p;
+    char buf[256];
+    int baud = 115200;
+    int use_pty = 0;
+    int script_running;
+    long quit_at = 0;
+    int opt;
+    int got;
+    int i;
+
+    while((opt = getopt(argc, argv, "l:j:e:n:s:b:p")) != -1){
+        switch(opt){
+            case 'l': latency_ms = atoi(optarg); break;
+            case 'j': jitter_ms = atoi(optarg); break;
+            case 'e': error_pct = atoi(optarg); break;
+            case 'n': noap_count = atoi(optarg); break;
+            case 'b': baud = atoi(optarg); break;
+            case 'p': use_pty = 1; break;
+            case 's':
+                if(!(script = fopen(optarg, "r"))){
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-l ms] [-j ms] [-e pct] [-n tries] "
+                        "[-s script] [-b baud] (-p | device)\n", argv[0]);
+                return 1;
+        }
+    }
+    if(use_pty){
+        if((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0 || grantpt(fd) || unlockpt(fd)){
+            perror("pty");
+            return 1;
+        }
+        printf("pty: %s\n", ptsname(fd));
+    } else if(optind >= argc || (fd = open(argv[optind], O_RDWR | O_NOCTTY)) < 0){
+        perror(optind < argc ? argv[optind] : "device");
+        return 1;
+    }
+    set_raw(baud);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    srand(start.tv_nsec);
+    fflush(stdout);
+
+    put("\r\nready\r\n");
+    script_running = script != NULL;
+
+    p.fd = fd;
+    p.events = POLLIN;
+    while(1){
+        if(poll(&p, 1, 10) > 0){
+            if((got = read(fd, buf, sizeof(buf))) <= 0){
+                break;
+            }
+            for(i = 0; i < got; i++){
+                rx_byte(buf[i]);
+            }
+        }
+        if(script_running && boot_done >= 0){
+            script_running = script_step();
+            if(!script_running){
+                quit_at = now_ms() + 500;   // Let the last replies finish
+            }
+        }
+        if(quit_at && now_ms() >= quit_at && send_link < 0){
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,510 @@
+/*
+ * fw_shim.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Runs the firmware on Linux against tools/esp32_sim, so boot and the
+ *  IOT command path can be timed without the car. Every firmware source
+ *  is built unchanged against shim/msp430.h except clocks.c, which only
+ *  trims the DCO, and timebase.c, whose 16 bit timer arithmetic needs
+ *  a 16 bit int. This file stands in for those, for the LCD library and
+ *  for the peripherals the IOT path uses:
+ *
+ *    - Timer B0: CCR0, CCR1, CCR2 and overflow interrupts at the times
+ *      the 1 MHz counter reaches them. The counter follows the host's
+ *      monotonic clock, so firmware time is real time.
+ *    - eUSCI_A0: the ESP32 port, a pty from esp32_sim -p or a serial
+ *      device. Bytes are delivered and sent one per character time at
+ *      the rate in UCA0BRW/UCA0MCTLW, so ^0000U changes it here too.
+ *      Nothing is read until the firmware raises IOT_EN.
+ *    - eUSCI_A1: the USB port, written to the -u file if given. Its
+ *      output is what telemetry_decode reads.
+ *    - LPM0: the CPU sleeps until an interrupt clears the bits on exit.
+ *
+ *  Interrupts are taken whenever GIE is set: on __enable_interrupt,
+ *  __set_interrupt_state and the LPM0 entry. The ADC and switches are
+ *  not run, so the detectors read 0 and the ISR profile and wake times
+ *  are not meaningful.
+ *
+ *  Printed on stdout, in firmware ms:
+ *
+ *    boot      iot_boot_ms once the server is up
+ *    command   each '^' command as its '\r' reaches UCA0RXBUF
+ *    motors    each change of the four TB3 PWM compare registers, with
+ *              the time since the last command's '\r' (command to
+ *              actuation latency)
+ *    display   the LCD lines when they change, with -d
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -w -fcommon -Ishim -I.. -Dmain=fw_main -o fw_shim fw_shim.c \
+ *       $(ls ../[a-z]*.c | grep -v -e clocks.c -e timebase.c)
+ *    ./esp32_sim -p -s scenarios/latency.txt     (prints pty: /dev/pts/N)
+ *    ./fw_shim [-d] [-u usb.bin] [-t seconds] /dev/pts/N
+ *  or scenarios/run.sh, which does both.
+ *
+ *  Functions included:
+ *    - now_us, now_ms: Firmware time, replacing timebase.c.
+ *    - Init_Clocks: Nothing to set up, replaces clocks.c.
+ *    - Init_LCD ... lcd_BIG_mid: LCD library stand-ins.
+ *    - __bis_SR_register ... __no_operation: Intrinsics, GIE and LPM0.
+ *    - hw_run: Runs every peripheral event due by now.
+ *    - watch: Reports boot, motor changes and the display.
+ *    - main: Opens the port and runs the firmware's main().
+ *
+ */
+
+
+#undef main
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "msp430.h"
+#include "ports.h"
+
+#define SMCLK_MHZ           (8)
+#define NEVER               (~0ULL)
+#define RX_QUEUE            (4096)
+#define CMD_TEXT            (32)
+
+//------------------------------------------------------------------------------
+// Registers
+//------------------------------------------------------------------------------
+#define REG16(name)         volatile unsigned short name
+#define REG8(name)          volatile unsigned char name
+#define PORT(n)             REG8(P##n##IN); REG8(P##n##OUT); REG8(P##n##DIR); \
+                            REG8(P##n##REN); REG8(P##n##SEL0); REG8(P##n##SEL1); \
+                            REG8(P##n##SELC); REG8(P##n##IE); REG8(P##n##IES); \
+                            REG8(P##n##IFG)
+
+REG16(ADCCTL0); REG16(ADCCTL1); REG16(ADCCTL2); REG16(ADCMCTL0); REG16(ADCMEM0);
+REG16(ADCHI); REG16(ADCLO); REG16(ADCIE); REG16(ADCIFG); REG16(ADCIV);
+REG16(CSCTL0); REG16(CSCTL1); REG16(CSCTL2); REG16(CSCTL3); REG16(CSCTL4);
+REG16(CSCTL5); REG16(CSCTL7); REG16(SFRIFG1); REG16(PM5CTL0); REG16(WDTCTL);
+REG16(SYSCFG0);
+REG16(TB0CTL); REG16(TB0R); REG16(TB0EX0); REG16(TB0IV);
+REG16(TB0CCR0); REG16(TB0CCR1); REG16(TB0CCR2);
+REG16(TB0CCTL0); REG16(TB0CCTL1); REG16(TB0CCTL2);
+REG16(TB1CTL); REG16(TB1R); REG16(TB1EX0); REG16(TB1IV);
+REG16(TB1CCR0); REG16(TB1CCR1); REG16(TB1CCR2);
+REG16(TB1CCTL0); REG16(TB1CCTL1); REG16(TB1CCTL2);
+REG16(TB3CTL); REG16(TB3CCR0); REG16(TB3CCR1); REG16(TB3CCR2); REG16(TB3CCR3);
+REG16(TB3CCR4); REG16(TB3CCR5); REG16(TB3CCTL1); REG16(TB3CCTL2);
+REG16(TB3CCTL3); REG16(TB3CCTL4); REG16(TB3CCTL5);
+REG16(UCA0CTLW0); REG16(UCA0BRW); REG16(UCA0MCTLW); REG16(UCA0STATW);
+REG16(UCA0RXBUF); REG16(UCA0TXBUF); REG16(UCA0IE); REG16(UCA0IFG); REG16(UCA0IV);
+REG16(UCA1CTLW0); REG16(UCA1BRW); REG16(UCA1MCTLW); REG16(UCA1STATW);
+REG16(UCA1RXBUF); REG16(UCA1TXBUF); REG16(UCA1IE); REG16(UCA1IFG); REG16(UCA1IV);
+PORT(1); PORT(2); PORT(3); PORT(4); PORT(5); PORT(6);
+
+//------------------------------------------------------------------------------
+// Firmware side
+//------------------------------------------------------------------------------
+void fw_main(void);
+void Timer0_B0_ISR(void);
+void TIMER0_B1_ISR(void);
+void eUSCI_A0_ISR(void);
+void eUSCI_A1_ISR(void);
+
+extern unsigned int iot_boot_ms;
+extern char display_line[4][11];
+
+char *display[4];                       // From the LCD library
+unsigned int menu;
+
+//------------------------------------------------------------------------------
+// Shim state. Times are us of firmware time.
+//------------------------------------------------------------------------------
+typedef struct {
+    volatile unsigned short *ie;
+    volatile unsigned short *iv;
+    volatile unsigned short *rxbuf;
+    volatile unsigned short *txbuf;
+    volatile unsigned short *brw;
+    volatile unsigned short *mctlw;
+    void (*isr)(void);
+    int fd;                             // -1 = nothing connected
+    unsigned long long tx_free;         // Transmitter can take the next byte
+    unsigned long long rx_next;         // Next byte has arrived
+    unsigned char rx[RX_QUEUE];
+    unsigned int rx_head;
+    unsigned int rx_tail;
+} shim_uart;
+
+static struct timespec start;
+static unsigned long long sim_us;       // Now
+static unsigned long long tb0_base;     // sim_us when TB0R was cleared
+static unsigned long long end_us = NEVER;
+static int gie;
+static int asleep;
+static int in_isr;
+static int show_display;
+static shim_uart uca0;
+static shim_uart uca1;
+
+volatile unsigned int tb0_overflows;
+
+static char cmd_text[CMD_TEXT];         // Command being received
+static int cmd_len = -1;                // -1 = not in a command
+static unsigned long long cmd_at;       // Its '\r' reached RXBUF
+static int cmd_waiting;                 // No motor change since it
+static unsigned short motors[4];
+static unsigned int boot_seen;
+
+static unsigned long long host_us(void){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - start.tv_sec) * 1000000ULL + (t.tv_nsec - start.tv_nsec) / 1000;
+}
+
+//------------------------------------------------------------------------------
+// timebase.c and clocks.c
+//------------------------------------------------------------------------------
+unsigned long now_us(void){
+    return (unsigned long)sim_us;
+}
+
+unsigned long now_ms(void){
+    return (unsigned long)(sim_us / 1000);
+}
+
+void Init_Clocks(void){
+}
+
+//------------------------------------------------------------------------------
+// LCD library
+//------------------------------------------------------------------------------
+void Init_LCD(void){
+}
+
+void lcd_BIG_mid(void){
+}
+
+void Display_Update(char p_L1, char p_L2, char p_L3, char p_L4){
+    int i;
+
+    (void)p_L1; (void)p_L2; (void)p_L3; (void)p_L4;
+    if(!show_display){
+        return;
+    }
+    printf("%10.3f ms  display", sim_us / 1000.0);
+    for(i = 0; i < 4; i++){
+        printf(" |%.10s|", display_line[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+// Peripherals
+//------------------------------------------------------------------------------
+
+// One 10 bit character at the rate set in BRW/MCTLW, SMCLK 8 MHz
+static unsigned long long char_us(const shim_uart *uart){
+    unsigned long clocks = *uart->brw;
+
+    if(*uart->mctlw & UCOS16){
+        clocks = clocks * 16 + ((*uart->mctlw >> 4) & 0x0F);
+    }
+    if(!clocks){
+        clocks = 1;
+    }
+    return (clocks * 10 + SMCLK_MHZ - 1) / SMCLK_MHZ;
+}
+
+// Time a 16 bit compare register is next reached by TB0R
+static unsigned long long tb0_match(unsigned short ccr){
+    unsigned long long count = sim_us - tb0_base;
+    unsigned long long delta = (unsigned short)(ccr - (unsigned short)count);
+
+    return sim_us + (delta ? delta : 0x10000);
+}
+
+static void uart_read(shim_uart *uart){
+    unsigned char buf[256];
+    unsigned long long t = host_us();
+    unsigned int space = RX_QUEUE - (uart->rx_head - uart->rx_tail);
+    int got;
+    int i;
+
+    if(uart->fd < 0 || !(P3OUT & IOT_EN) || space < sizeof(buf)){
+        return;                         // ESP32 still held in reset
+    }
+    got = read(uart->fd, buf, sizeof(buf));
+    if(got == 0 || (got < 0 && errno == EIO)){
+        end_us = sim_us;                // esp32_sim has gone
+        return;
+    }
+    if(got > 0 && uart->rx_head == uart->rx_tail){
+        uart->rx_next = (t > sim_us ? t : sim_us) + char_us(uart);
+    }
+    for(i = 0; i < got; i++){
+        uart->rx[uart->rx_head++ % RX_QUEUE] = buf[i];
+    }
+}
+
+static void uart_receive(shim_uart *uart){
+    unsigned char c = uart->rx[uart->rx_tail++ % RX_QUEUE];
+
+    uart->rx_next = uart->rx_head != uart->rx_tail ? sim_us + char_us(uart) : NEVER;
+    if(!(*uart->ie & UCRXIE)){
+        return;                         // Receiver off, byte lost
+    }
+    if(uart == &uca0){
+        if(c == '^'){
+            cmd_len = 0;
+        } else if(c == '\r' && cmd_len >= 0){
+            cmd_text[cmd_len] = 0;
+            cmd_at = sim_us;
+            cmd_waiting = TRUE;
+            cmd_len = -1;
+            printf("%10.3f ms  command ^%s\n", sim_us / 1000.0, cmd_text);
+        } else if(cmd_len >= 0 && cmd_len < CMD_TEXT - 1){
+            cmd_text[cmd_len++] = c;
+        }
+    }
+    *uart->rxbuf = c;
+    *uart->iv = 2;
+    uart->isr();
+}
+
+static void uart_transmit(shim_uart *uart){
+    unsigned char c;
+
+    *uart->txbuf = 0xFFFF;              // No byte can look like this
+    *uart->iv = 4;
+    uart->isr();
+    uart->tx_free = sim_us + char_us(uart);
+    if(*uart->txbuf == 0xFFFF){
+        return;
+    }
+    c = (unsigned char)*uart->txbuf;
+    if(uart->fd >= 0 && write(uart->fd, &c, 1) < 0 && uart == &uca0){
+        end_us = sim_us;
+    }
+}
+
+static void tb0_interrupt(unsigned short iv){
+    TB0IV = iv;
+    TIMER0_B1_ISR();
+}
+
+//-----------------------------------------------------------------
+// Takes every interrupt due between the last call and now, in time
+// order, with TB0R at the time each one happens.
+//-----------------------------------------------------------------
+static unsigned long long next_event(int *which){
+    unsigned long long next = NEVER;
+    unsigned long long t;
+
+    *which = -1;
+    if(TB0CTL & (MC__UP | MC__CONTINUOUS)){
+        if(TB0CCTL0 & CCIE && (t = tb0_match(TB0CCR0)) < next){ next = t; *which = 0; }
+        if(TB0CCTL1 & CCIE && (t = tb0_match(TB0CCR1)) < next){ next = t; *which = 1; }
+        if(TB0CCTL2 & CCIE && (t = tb0_match(TB0CCR2)) < next){ next = t; *which = 2; }
+        if(TB0CTL & TBIE && (t = tb0_match(0)) < next){ next = t; *which = 3; }
+    }
+    if(uca0.rx_head != uca0.rx_tail && uca0.rx_next < next){ next = uca0.rx_next; *which = 4; }
+    if(UCA0IE & UCTXIE && (t = uca0.tx_free > sim_us ? uca0.tx_free : sim_us) < next){ next = t; *which = 5; }
+    if(UCA1IE & UCTXIE && (t = uca1.tx_free > sim_us ? uca1.tx_free : sim_us) < next){ next = t; *which = 6; }
+    return next;
+}
+
+static void hw_run(void){
+    unsigned long long target;
+    unsigned long long at;
+    int saved_gie = gie;
+    int which;
+
+    if(in_isr){
+        return;
+    }
+    in_isr = TRUE;
+    gie = FALSE;                        // As on entry to an ISR
+    if(TB0CTL & TBCLR){
+        TB0CTL &= ~TBCLR;
+        tb0_base = sim_us;
+    }
+    uart_read(&uca0);
+    target = host_us();
+    while((at = next_event(&which)) <= target){
+        sim_us = at > sim_us ? at : sim_us;
+        TB0R = (unsigned short)(sim_us - tb0_base);
+        tb0_overflows = (unsigned int)((sim_us - tb0_base) >> 16);
+        switch(which){
+            case 0: Timer0_B0_ISR(); break;
+            case 1: tb0_interrupt(2); break;
+            case 2: tb0_interrupt(4); break;
+            case 3: tb0_interrupt(14); break;
+            case 4: uart_receive(&uca0); break;
+            case 5: uart_transmit(&uca0); break;
+            case 6: uart_transmit(&uca1); break;
+            default: break;
+        }
+    }
+    if(target > sim_us){
+        sim_us = target;
+    }
+    TB0R = (unsigned short)(sim_us - tb0_base);
+    gie = saved_gie;
+    in_isr = FALSE;
+}
+
+static void watch(void){
+    unsigned short now[4] = {RIGHT_FORWARD_SPEED, RIGHT_REVERSE_SPEED,
+                             LEFT_FORWARD_SPEED, LEFT_REVERSE_SPEED};
+
+    if(iot_boot_ms && !boot_seen){
+        boot_seen = iot_boot_ms;
+        printf("%10.3f ms  boot %u ms, reset to server ready\n", sim_us / 1000.0, iot_boot_ms);
+    }
+    if(memcmp(now, motors, sizeof(motors))){
+        memcpy(motors, now, sizeof(motors));
+        printf("%10.3f ms  motors R %u/%u L %u/%u", sim_us / 1000.0,
+               now[0], now[1], now[2], now[3]);
+        if(cmd_waiting){
+            printf(", %.3f ms after the command", (sim_us - cmd_at) / 1000.0);
+            cmd_waiting = FALSE;
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+    if(sim_us >= end_us){
+        exit(0);
+    }
+}
+
+//-----------------------------------------------------------------
+// The CPU sleeps until an ISR clears CPUOFF on its way out. Waits on
+// the port so received bytes wake it as soon as they come in.
+//-----------------------------------------------------------------
+static void sleep_until_woken(void){
+    struct pollfd p;
+    struct timespec wait;
+    unsigned long long next;
+    unsigned long long t;
+    int which;
+
+    while(asleep){
+        hw_run();
+        watch();
+        if(!asleep){
+            break;
+        }
+        next = next_event(&which);
+        t = host_us();
+        next = next > t ? next - t : 0;
+        if(next > 10000){
+            next = 10000;
+        }
+        wait.tv_sec = 0;
+        wait.tv_nsec = next * 1000;
+        p.fd = uca0.fd;
+        p.events = POLLIN;
+        ppoll(&p, (P3OUT & IOT_EN) ? 1 : 0, &wait, NULL);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Intrinsics
+//------------------------------------------------------------------------------
+void __bis_SR_register(unsigned int bits){
+    if(bits & GIE){
+        gie = TRUE;
+    }
+    if(bits & CPUOFF){
+        asleep = TRUE;
+        sleep_until_woken();
+    } else if(gie){
+        hw_run();
+    }
+}
+
+void __bic_SR_register(unsigned int bits){
+    if(bits & GIE){
+        gie = FALSE;
+    }
+}
+
+void __bis_SR_register_on_exit(unsigned int bits){
+    (void)bits;
+}
+
+void __bic_SR_register_on_exit(unsigned int bits){
+    if(bits & CPUOFF){
+        asleep = FALSE;
+    }
+}
+
+unsigned int __get_SR_register(void){
+    return gie ? GIE : 0;
+}
+
+void __disable_interrupt(void){
+    gie = FALSE;
+}
+
+void __enable_interrupt(void){
+    gie = TRUE;
+    hw_run();
+    watch();
+}
+
+unsigned int __get_interrupt_state(void){
+    return gie ? GIE : 0;
+}
+
+void __set_interrupt_state(unsigned int state){
+    gie = (state & GIE) != 0;
+    if(gie){
+        hw_run();
+    }
+}
+
+void __no_operation(void){
+}
+
+int main(int argc, char *argv[]){
+    const char *usb_file = NULL;
+    int opt;
+
+    while((opt = getopt(argc, argv, "du:t:")) != -1){
+        switch(opt){
+            case 'd': show_display = TRUE; break;
+            case 'u': usb_file = optarg; break;
+            case 't': end_us = strtoull(optarg, NULL, 10) * 1000000ULL; break;
+            default:
+                fprintf(stderr, "usage: %s [-d] [-u usb_file] [-t seconds] port\n", argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc){
+        fprintf(stderr, "usage: %s [-d] [-u usb_file] [-t seconds] port\n", argv[0]);
+        return 1;
+    }
+
+    uca0 = (shim_uart){&UCA0IE, &UCA0IV, &UCA0RXBUF, &UCA0TXBUF, &UCA0BRW, &UCA0MCTLW, eUSCI_A0_ISR, -1, 0, NEVER, {0}, 0, 0};
+    uca1 = (shim_uart){&UCA1IE, &UCA1IV, &UCA1RXBUF, &UCA1TXBUF, &UCA1BRW, &UCA1MCTLW, eUSCI_A1_ISR, -1, 0, NEVER, {0}, 0, 0};
+    if((uca0.fd = open(argv[optind], O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0){
+        perror(argv[optind]);
+        return 1;
+    }
+    if(usb_file && (uca1.fd = open(usb_file, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0){
+        perror(usb_file);
+        return 1;
+    }
+    P1IN = P2IN = P3IN = P4IN = P5IN = P6IN = 0xFF;    // Switches up
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fw_main();
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * ringbuf_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host test and benchmark for ringbuf.c, built from the firmware source.
+ *  The unit tests cover the counters, overrun, high water, the 16 bit
+ *  head and tail wrapping (past 0xFFFF on the MSP430, past the top of
+ *  a host unsigned int here), ring_peek across the end of the
+ *  storage, and the ring_write / ring_consume clamps.
+ *
+ *  The benchmark replays ESP32 traffic (+IPD commands, OK and SEND OK)
+ *  into a ring at 460800 baud, one byte every 21.7 us as eUSCI_A0_ISR
+ *  would put it, while the main loop drains it with ring_peek every
+ *  drain period. It prints the longest drain period that loses nothing
+ *  for the IOT and USB ring sizes, checks that every byte comes out in
+ *  order, and times the put and drain paths on the host.
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -I.. -o ringbuf_test ringbuf_test.c ../ringbuf.c
+ *    ./ringbuf_test
+ *
+ *  Functions included:
+ *    - check: Counts and prints a failed test.
+ *    - test_basic: Counters, put, get, peek_at and flush.
+ *    - test_overrun: Filling past the size and the high water mark.
+ *    - test_wrap: Counters wrapping, peeks across the end.
+ *    - test_block: ring_write and ring_consume limits.
+ *    - replay: Feeds the traffic at line rate, returns bytes lost.
+ *    - bench: Finds the longest safe drain period and times the ring.
+ *    - main: Runs the tests and the benchmark.
+ *
+ */
+
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ringbuf.h"
+#include "macros.h"
+
+#define BAUD            (460800L)
+#define BYTE_NS         (10L * 1000000000L / BAUD)  // 8N1, 21701 ns
+#define REPLAY_BYTES    (200000L)
+#define TIME_BYTES      (20000000L)
+
+static const char traffic[] =
+    "+IPD,0,7:^1234F1\r\n"
+    "+IPD,0,15:^1234S100,100\r\n\r\n"
+    "OK\r\n"
+    "+IPD,1,7:^1234Q\r\n"
+    "\r\nSEND OK\r\n"
+    "+IPD,0,12:^1234L0,0,0\r\n";
+
+static int failures;
+
+static void check(int ok, const char *what){
+    if(!ok){
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void test_basic(void){
+    char storage[16];
+    ring_buf ring;
+    char c = 0;
+
+    ring_init(&ring, storage, sizeof(storage));
+    check(ring_count(&ring) == 0, "empty count");
+    check(ring_space(&ring) == 16, "empty space");
+    check(!ring_get(&ring, &c), "get from empty");
+    check(ring_put(&ring, 'a') && ring_put(&ring, 'b'), "put");
+    check(ring_count(&ring) == 2 && ring_space(&ring) == 14, "count after put");
+    check(ring_peek_at(&ring, 1) == 'b', "peek_at");
+    check(ring_get(&ring, &c) && c == 'a', "get order");
+    check(ring_count(&ring) == 1, "count after get");
+    ring_flush(&ring);
+    check(ring_count(&ring) == 0 && ring_space(&ring) == 16, "flush");
+    check(ring.overrun == 0, "no overrun");
+}
+
+static void test_overrun(void){
+    char storage[8];
+    ring_buf ring;
+    char c = 0;
+    int i;
+
+    ring_init(&ring, storage, sizeof(storage));
+    for(i = 0; i < 8; i++){
+        check(ring_put(&ring, (char)('0' + i)), "put to full");
+    }
+    check(ring_space(&ring) == 0, "full space");
+    check(!ring_put(&ring, 'x') && !ring_put(&ring, 'y'), "put when full");
+    check(ring.overrun == 2, "overrun count");
+    check(ring.high_water == 8, "high water at full");
+    check(ring_get(&ring, &c) && c == '0', "oldest kept on overrun");
+    ring_flush(&ring);
+    ring_put(&ring, 'z');
+    check(ring.high_water == 8, "high water kept after flush");
+}
+
+static void test_wrap(void){
+    char storage[16];
+    ring_buf ring;
+    const char *data;
+    unsigned int length;
+    char c = 0;
+    int i;
+
+    // Counters 6 short of wrapping, 0xFFFA on the MSP430, index 10
+    ring_init(&ring, storage, sizeof(storage));
+    ring.head = (unsigned int)-6;
+    ring.tail = (unsigned int)-6;
+    for(i = 0; i < 12; i++){
+        ring_put(&ring, (char)('a' + i));
+    }
+    check(ring.head == 6, "head wrapped");
+    check(ring_count(&ring) == 12 && ring_space(&ring) == 4, "count across wrap");
+    check(ring_peek_at(&ring, 11) == 'l', "peek_at across wrap");
+
+    length = ring_peek(&ring, &data);
+    check(length == 6 && data == &storage[10] && !memcmp(data, "abcdef", 6), "first peek to end");
+    ring_consume(&ring, length);
+    length = ring_peek(&ring, &data);
+    check(length == 6 && data == &storage[0] && !memcmp(data, "ghijkl", 6), "second peek from start");
+    ring_consume(&ring, length);
+    check(ring_count(&ring) == 0 && ring.tail == 6, "drained across wrap");
+    check(!ring_get(&ring, &c), "empty after wrap");
+    check(ring_peek(&ring, &data) == 0, "peek when empty");
+
+    // Full ring straddling the wrap still refuses the next byte
+    ring.head = (unsigned int)-8;
+    ring.tail = (unsigned int)-8;
+    ring.overrun = 0;
+    for(i = 0; i < 16; i++){
+        ring_put(&ring, 'w');
+    }
+    check(!ring_put(&ring, 'x') && ring.overrun == 1, "full across wrap");
+}
+
+static void test_block(void){
+    char storage[8];
+    ring_buf ring;
+    const char *data;
+
+    ring_init(&ring, storage, sizeof(storage));
+    check(ring_write(&ring, "12345", 5) == 5, "write fits");
+    check(ring_write(&ring, "6789AB", 6) == 3, "write partial");
+    check(ring.overrun == 3 && ring.high_water == 8, "write overrun");
+    ring_consume(&ring, 3);
+    check(ring_peek(&ring, &data) == 5 && !memcmp(data, "45678", 5), "peek after consume");
+    ring_consume(&ring, 100);
+    check(ring_count(&ring) == 0, "consume clamped");
+    check(ring_write(&ring, "ABCDEF", 6) == 6, "write across end");
+    check(ring_peek_at(&ring, 5) == 'F', "written across end");
+}
+
+//-----------------------------------------------------------------
+// Bytes arrive every BYTE_NS, the main loop drains whatever is
+// waiting every drain_us. Returns the overrun count, or -1 if a
+// byte came out wrong.
+//-----------------------------------------------------------------
+static long replay(unsigned int size, long drain_us, unsigned int *high_water){
+    static char storage[1024];
+    ring_buf ring;
+    const char *data;
+    unsigned int length;
+    unsigned int i;
+    long sent;
+    long next_drain = drain_us * 1000L;
+    long now = 0;
+    long expect = 0;
+    long lost;
+
+    ring_init(&ring, storage, size);
+    for(sent = 0; sent < REPLAY_BYTES; sent++){
+        now += BYTE_NS;
+        while(now >= next_drain){
+            while((length = ring_peek(&ring, &data)) != 0){
+                for(i = 0; i < length; i++){
+                    if(!ring.overrun && data[i] != traffic[expect % (sizeof(traffic) - 1)]){
+                        return -1;      // Only checked until the first loss
+                    }
+                    expect++;
+                }
+                ring_consume(&ring, length);
+            }
+            next_drain += drain_us * 1000L;
+        }
+        ring_put(&ring, traffic[sent % (sizeof(traffic) - 1)]);
+    }
+    lost = ring.overrun;
+    *high_water = ring.high_water;
+    return lost;
+}
+
+static double elapsed_ns(const struct timespec *start){
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+static void bench(void){
+    static const unsigned int sizes[] = {IOT_RX_SIZE, USB_RX_SIZE};
+    static char storage[IOT_RX_SIZE];
+    ring_buf ring;
+    const char *data;
+    struct timespec start;
+    unsigned int high_water = 0;
+    unsigned int length;
+    unsigned int s;
+    volatile unsigned int sum = 0;
+    long drain_us;
+    long best;
+    long lost;
+    long n;
+
+    printf("%ld baud, %ld ns per byte, %ld bytes of ESP32 traffic\n", BAUD, BYTE_NS, REPLAY_BYTES);
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        best = 0;
+        for(drain_us = 100; drain_us <= 20000; drain_us += 100){
+            lost = replay(sizes[s], drain_us, &high_water);
+            check(lost >= 0, "replay order");
+            if(lost != 0){
+                break;
+            }
+            best = drain_us;
+        }
+        lost = replay(sizes[s], 10000, &high_water);
+        printf("  %3u byte ring: drain every %ld us or less, at 10 ms %ld lost (%.1f%%)\n",
+               sizes[s], best, lost, 100.0 * lost / REPLAY_BYTES);
+    }
+
+    ring_init(&ring, storage, sizeof(storage));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(n = 0; n < TIME_BYTES; n++){
+        ring_put(&ring, (char)n);
+        if((n & 63) == 63){
+            while((length = ring_peek(&ring, &data)) != 0){
+                sum += (unsigned char)data[0];
+                ring_consume(&ring, length);
+            }
+        }
+    }
+    printf("  host: %.2f ns per byte, put plus block drain\n", elapsed_ns(&start) / TIME_BYTES);
+}
+
+int main(void){
+    test_basic();
+    test_overrun();
+    test_wrap();
+    test_block();
+    if(failures){
+        printf("%d failed\n", failures);
+        return 1;
+    }
+    printf("ring tests passed\n");
+    bench();
+    return failures != 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Runs a scenario against the firmware on the host, from tools:
+#   scenarios/run.sh scenarios/latency.txt [esp32_sim options]
+# esp32_sim and fw_shim have to be built first, see their headers.
+script=$1
+shift
+./esp32_sim -p -s "$script" "$@" | {
+    read -r pty path
+    [ "$pty" = "pty:" ] || exit 1
+    ./fw_shim -t 30 "$path" &
+    cat
+    wait
+}
@@ -0,0 +1,243 @@
+/*
+ * msp430.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Stand-in for TI's msp430.h when the firmware is built on Linux by
+ *  tools/fw_shim.c. Only the registers and bits the firmware uses are
+ *  here. Registers are plain variables defined in fw_shim.c, sized like
+ *  the real ones so 16 bit compare registers wrap the same way; the bit
+ *  values are the MSP430FR2355 ones. The intrinsics are functions in
+ *  fw_shim.c, which is where the peripherals are run.
+ */
+
+#ifndef SHIM_MSP430_H_
+#define SHIM_MSP430_H_
+
+#define SHIM_REG16(name)    extern volatile unsigned short name
+#define SHIM_REG8(name)     extern volatile unsigned char name
+
+// ADC
+SHIM_REG16(ADCCTL0);
+SHIM_REG16(ADCCTL1);
+SHIM_REG16(ADCCTL2);
+SHIM_REG16(ADCMCTL0);
+SHIM_REG16(ADCMEM0);
+SHIM_REG16(ADCHI);
+SHIM_REG16(ADCLO);
+SHIM_REG16(ADCIE);
+SHIM_REG16(ADCIFG);
+SHIM_REG16(ADCIV);
+
+#define ADCSC               (0x0001)
+#define ADCENC              (0x0002)
+#define ADCON               (0x0010)
+#define ADCMSC              (0x0080)
+#define ADCSHT_2            (0x0200)
+#define ADCBUSY             (0x0001)
+#define ADCCONSEQ_2         (0x0004)
+#define ADCSSEL_0           (0x0000)
+#define ADCDIV_0            (0x0000)
+#define ADCISSH             (0x0100)
+#define ADCSHP              (0x0200)
+#define ADCSHS_1            (0x0400)
+#define ADCDF               (0x0008)
+#define ADCSR               (0x0004)
+#define ADCRES_2            (0x0020)
+#define ADCPDIV0            (0x0100)
+#define ADCSREF_0           (0x0000)
+#define ADCINCH             (0x000F)
+#define ADCINCH_2           (0x0002)
+#define ADCINCH_3           (0x0003)
+#define ADCINCH_5           (0x0005)
+#define ADCINCH_8           (0x0008)
+#define ADCINCH_9           (0x0009)
+#define ADCINCH_11          (0x000B)
+#define ADCIE0              (0x0001)
+#define ADCINIE             (0x0002)
+#define ADCLOIE             (0x0004)
+#define ADCHIIE             (0x0008)
+#define ADCOVIE             (0x0010)
+#define ADCTOVIE            (0x0020)
+#define ADCIFG0             (0x0001)
+#define ADCINIFG            (0x0002)
+#define ADCLOIFG            (0x0004)
+#define ADCHIIFG            (0x0008)
+#define ADCIV_NONE          (0x0000)
+#define ADCIV_ADCOVIFG      (0x0002)
+#define ADCIV_ADCTOVIFG     (0x0004)
+#define ADCIV_ADCHIIFG      (0x0006)
+#define ADCIV_ADCLOIFG      (0x0008)
+#define ADCIV_ADCINIFG      (0x000A)
+#define ADCIV_ADCIFG        (0x000C)
+
+// Clock system, only Init_Clocks uses these and fw_shim.c replaces it
+SHIM_REG16(CSCTL0);
+SHIM_REG16(CSCTL1);
+SHIM_REG16(CSCTL2);
+SHIM_REG16(CSCTL3);
+SHIM_REG16(CSCTL4);
+SHIM_REG16(CSCTL5);
+SHIM_REG16(CSCTL7);
+SHIM_REG16(SFRIFG1);
+SHIM_REG16(PM5CTL0);
+SHIM_REG16(WDTCTL);
+SHIM_REG16(SYSCFG0);
+
+#define DCOFFG              (0x0001)
+#define XT1OFFG             (0x0002)
+#define FLLUNLOCK0          (0x0100)
+#define FLLUNLOCK1          (0x0200)
+#define DCOFTRIM            (0x0070)
+#define DCOFTRIM0           (0x0010)
+#define DCOFTRIM1           (0x0020)
+#define DCOFTRIMEN_1        (0x0080)
+#define DCORSEL_3           (0x0006)
+#define FLLD_0              (0x0000)
+#define DIVM__1             (0x0000)
+#define DIVM__4             (0x0002)
+#define DIVS__1             (0x0000)
+#define DIVS__4             (0x0020)
+#define SELA__XT1CLK        (0x0000)
+#define SELMS__DCOCLKDIV    (0x0000)
+#define SELREF__XT1CLK      (0x0000)
+#define OFIFG               (0x0002)
+#define LOCKLPM5            (0x0001)
+#define WDTPW               (0x5A00)
+#define WDTHOLD             (0x0080)
+#define FRWPPW              (0xA500)
+#define PFWP                (0x0001)
+#define DFWP                (0x0002)
+
+// Timers
+SHIM_REG16(TB0CTL);
+SHIM_REG16(TB0R);
+SHIM_REG16(TB0EX0);
+SHIM_REG16(TB0IV);
+SHIM_REG16(TB0CCR0);
+SHIM_REG16(TB0CCR1);
+SHIM_REG16(TB0CCR2);
+SHIM_REG16(TB0CCTL0);
+SHIM_REG16(TB0CCTL1);
+SHIM_REG16(TB0CCTL2);
+SHIM_REG16(TB1CTL);
+SHIM_REG16(TB1R);
+SHIM_REG16(TB1EX0);
+SHIM_REG16(TB1IV);
+SHIM_REG16(TB1CCR0);
+SHIM_REG16(TB1CCR1);
+SHIM_REG16(TB1CCR2);
+SHIM_REG16(TB1CCTL0);
+SHIM_REG16(TB1CCTL1);
+SHIM_REG16(TB1CCTL2);
+SHIM_REG16(TB3CTL);
+SHIM_REG16(TB3CCR0);
+SHIM_REG16(TB3CCR1);
+SHIM_REG16(TB3CCR2);
+SHIM_REG16(TB3CCR3);
+SHIM_REG16(TB3CCR4);
+SHIM_REG16(TB3CCR5);
+SHIM_REG16(TB3CCTL1);
+SHIM_REG16(TB3CCTL2);
+SHIM_REG16(TB3CCTL3);
+SHIM_REG16(TB3CCTL4);
+SHIM_REG16(TB3CCTL5);
+
+#define TBIFG               (0x0001)
+#define TBIE                (0x0002)
+#define TBCLR               (0x0004)
+#define MC__STOP            (0x0000)
+#define MC__UP              (0x0010)
+#define MC__CONTINUOUS      (0x0020)
+#define MC__CONTINOUS       (MC__CONTINUOUS)
+#define ID__1               (0x0000)
+#define ID__2               (0x0040)
+#define ID__4               (0x0080)
+#define ID__8               (0x00C0)
+#define TBSSEL__SMCLK       (0x0200)
+#define CCIFG               (0x0001)
+#define CCIE                (0x0010)
+#define OUTMOD_7            (0x00E0)
+
+// eUSCI_A0 (IOT) and eUSCI_A1 (USB)
+SHIM_REG16(UCA0CTLW0);
+SHIM_REG16(UCA0BRW);
+SHIM_REG16(UCA0MCTLW);
+SHIM_REG16(UCA0STATW);
+SHIM_REG16(UCA0RXBUF);
+SHIM_REG16(UCA0TXBUF);
+SHIM_REG16(UCA0IE);
+SHIM_REG16(UCA0IFG);
+SHIM_REG16(UCA0IV);
+SHIM_REG16(UCA1CTLW0);
+SHIM_REG16(UCA1BRW);
+SHIM_REG16(UCA1MCTLW);
+SHIM_REG16(UCA1STATW);
+SHIM_REG16(UCA1RXBUF);
+SHIM_REG16(UCA1TXBUF);
+SHIM_REG16(UCA1IE);
+SHIM_REG16(UCA1IFG);
+SHIM_REG16(UCA1IV);
+
+#define UCSWRST             (0x0001)
+#define UCSSEL__SMCLK       (0x0080)
+#define UCSYNC              (0x0100)
+#define UCMODE_0            (0x0000)
+#define UCSPB               (0x0800)
+#define UC7BIT              (0x1000)
+#define UCMSB               (0x2000)
+#define UCPEN               (0x8000)
+#define UCOS16              (0x0001)
+#define UCBUSY              (0x0001)
+#define UCOE                (0x0020)
+#define UCRXIE              (0x0001)
+#define UCTXIE              (0x0002)
+#define UCRXIFG             (0x0001)
+#define UCTXIFG             (0x0002)
+
+// Ports
+SHIM_REG8(P1IN);  SHIM_REG8(P1OUT); SHIM_REG8(P1DIR); SHIM_REG8(P1REN);
+SHIM_REG8(P1SEL0); SHIM_REG8(P1SEL1); SHIM_REG8(P1SELC);
+SHIM_REG8(P1IE);  SHIM_REG8(P1IES); SHIM_REG8(P1IFG);
+SHIM_REG8(P2IN);  SHIM_REG8(P2OUT); SHIM_REG8(P2DIR); SHIM_REG8(P2REN);
+SHIM_REG8(P2SEL0); SHIM_REG8(P2SEL1); SHIM_REG8(P2SELC);
+SHIM_REG8(P2IE);  SHIM_REG8(P2IES); SHIM_REG8(P2IFG);
+SHIM_REG8(P3IN);  SHIM_REG8(P3OUT); SHIM_REG8(P3DIR); SHIM_REG8(P3REN);
+SHIM_REG8(P3SEL0); SHIM_REG8(P3SEL1); SHIM_REG8(P3SELC);
+SHIM_REG8(P3IE);  SHIM_REG8(P3IES); SHIM_REG8(P3IFG);
+SHIM_REG8(P4IN);  SHIM_REG8(P4OUT); SHIM_REG8(P4DIR); SHIM_REG8(P4REN);
+SHIM_REG8(P4SEL0); SHIM_REG8(P4SEL1); SHIM_REG8(P4SELC);
+SHIM_REG8(P4IE);  SHIM_REG8(P4IES); SHIM_REG8(P4IFG);
+SHIM_REG8(P5IN);  SHIM_REG8(P5OUT); SHIM_REG8(P5DIR); SHIM_REG8(P5REN);
+SHIM_REG8(P5SEL0); SHIM_REG8(P5SEL1); SHIM_REG8(P5SELC);
+SHIM_REG8(P5IE);  SHIM_REG8(P5IES); SHIM_REG8(P5IFG);
+SHIM_REG8(P6IN);  SHIM_REG8(P6OUT); SHIM_REG8(P6DIR); SHIM_REG8(P6REN);
+SHIM_REG8(P6SEL0); SHIM_REG8(P6SEL1); SHIM_REG8(P6SELC);
+SHIM_REG8(P6IE);  SHIM_REG8(P6IES); SHIM_REG8(P6IFG);
+
+// Status register and intrinsics
+#define GIE                 (0x0008)
+#define CPUOFF              (0x0010)
+#define SCG0                (0x0040)
+#define SCG1                (0x0080)
+#define LPM0_bits           (CPUOFF)
+#define LPM3_bits           (SCG1 | SCG0 | CPUOFF)
+#define LPM0                __bis_SR_register(LPM0_bits)
+
+#define __interrupt
+#define __even_in_range(value, bound)   (value)
+#define __delay_cycles(cycles)          ((void)(cycles))
+
+void __bis_SR_register(unsigned int bits);
+void __bic_SR_register(unsigned int bits);
+void __bis_SR_register_on_exit(unsigned int bits);
+void __bic_SR_register_on_exit(unsigned int bits);
+unsigned int __get_SR_register(void);
+void __disable_interrupt(void);
+void __enable_interrupt(void);
+unsigned int __get_interrupt_state(void);
+void __set_interrupt_state(unsigned int state);
+void __no_operation(void);
+
+#endif /* SHIM_MSP430_H_ */
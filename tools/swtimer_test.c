@@ -0,0 +1,277 @@
+/*
+ * swtimer_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host test for swtimer.c, built from the firmware source against
+ *  shim/msp430.h. The intrinsics here only keep a GIE flag, and the
+ *  test calls swt_tick itself in place of Timer0_B0_ISR. Checked:
+ *
+ *    - ordering: timers fire on their own tick whatever order they
+ *      were started in, and ones due on the same tick fire in the
+ *      order they were started,
+ *    - cancellation: cancelling the first, a middle or the last timer
+ *      leaves the others firing on time, a restart moves a running
+ *      timer, and a cancelled timer's fired flag is cleared,
+ *    - wrap-around: a 0xFFFF tick timer and a periodic one run past
+ *      the 16 bit tick count without drift or lost expiries,
+ *    - interrupt state: swt_start and swt_cancel leave GIE as they
+ *      found it.
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -Ishim -I.. -o swtimer_test swtimer_test.c ../swtimer.c
+ *    ./swtimer_test
+ *
+ *  Functions included:
+ *    - __disable_interrupt ... __set_interrupt_state: GIE only.
+ *    - run: Ticks and records which timers fired on which tick.
+ *    - same_tick_order: Checks the list order of same-tick timers.
+ *    - expect: Compares the record with the expected firing.
+ *    - main: Runs the cases and prints the failures.
+ *
+ */
+
+
+#include <stdio.h>
+#include "msp430.h"
+#include "macros.h"
+#include "swtimer.h"
+
+#define TIMERS          (6)
+#define MAX_FIRES       (16)
+
+extern sw_timer *swt_head;
+
+static unsigned int gie;
+static sw_timer timers[TIMERS];
+static unsigned int fired_tick[MAX_FIRES];
+static int fired_id[MAX_FIRES];
+static unsigned int fires;
+static unsigned int fire_count[TIMERS];
+static unsigned int last_tick[TIMERS];
+static unsigned int now;                // Ticks since reset
+static unsigned int failures;
+
+void __disable_interrupt(void){
+    gie = 0;
+}
+
+void __enable_interrupt(void){
+    gie = GIE;
+}
+
+unsigned int __get_interrupt_state(void){
+    return gie;
+}
+
+void __set_interrupt_state(unsigned int state){
+    gie = state & GIE;
+}
+
+static void reset(void){
+    unsigned int i;
+
+    for(i = 0; i < TIMERS; i++){
+        swt_cancel(&timers[i]);
+    }
+    swt_head = NULL;
+    fires = 0;
+    now = 0;
+    for(i = 0; i < TIMERS; i++){
+        fire_count[i] = 0;
+        last_tick[i] = 0;
+    }
+}
+
+//-----------------------------------------------------------------
+// Ticks <ticks> times. After each tick the fired flags are read in
+// timer order, the way the main loop would, and counted. The first
+// MAX_FIRES are recorded for expect(). Every delta in the list has to
+// fit the MSP430's 16 bit unsigned int.
+//-----------------------------------------------------------------
+static void run(unsigned int ticks){
+    sw_timer *timer;
+    unsigned int i;
+
+    while(ticks--){
+        now++;
+        swt_tick();
+        for(timer = swt_head; timer; timer = timer->next){
+            if(timer->delta > 0xFFFF){
+                printf("FAIL: delta %u over 16 bits at tick %u\n", timer->delta, now);
+                failures++;
+            }
+        }
+        for(i = 0; i < TIMERS; i++){
+            if(!swt_fired(&timers[i])){
+                continue;
+            }
+            fire_count[i]++;
+            last_tick[i] = now;
+            if(fires < MAX_FIRES){
+                fired_tick[fires] = now;
+                fired_id[fires++] = i;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------
+// <expected> is pairs of timer and tick, ended by -1.
+//-----------------------------------------------------------------
+static void expect(const char *name, const int *expected){
+    unsigned int i;
+
+    for(i = 0; expected[i * 2] >= 0; i++){
+        if(i >= fires || fired_id[i] != expected[i * 2] ||
+           fired_tick[i] != (unsigned int)expected[i * 2 + 1]){
+            break;
+        }
+    }
+    if(expected[i * 2] >= 0 || i != fires){
+        printf("FAIL: %s, fired", name);
+        for(i = 0; i < fires; i++){
+            printf(" %d@%u", fired_id[i], fired_tick[i]);
+        }
+        printf("\n");
+        failures++;
+    }
+}
+
+// Same-tick expiries come off the list together, so check the order
+// the ISR fired them in, not the order run() reads the flags.
+static void same_tick_order(void){
+    unsigned int i;
+    sw_timer *order[3];
+    sw_timer *timer;
+
+    reset();
+    swt_start(&timers[4], 3, SWT_ONE_SHOT);
+    swt_start(&timers[1], 3, SWT_ONE_SHOT);
+    swt_start(&timers[2], 3, SWT_ONE_SHOT);
+    for(i = 0, timer = swt_head; timer && i < 3; timer = timer->next){
+        order[i++] = timer;
+    }
+    if(i != 3 || order[0] != &timers[4] || order[1] != &timers[1] || order[2] != &timers[2]){
+        printf("FAIL: same tick timers not in start order\n");
+        failures++;
+    }
+}
+
+int main(void){
+    static const int ordering[] = {3, 1,  1, 3,  0, 5,  2, 5,  -1};
+    static const int cancel_middle[] = {0, 2,  2, 9,  -1};
+    static const int cancel_first[] = {1, 6,  2, 9,  -1};
+    static const int cancel_last[] = {0, 2,  1, 6,  -1};
+    static const int restart[] = {1, 4,  0, 10,  -1};
+    static const int periodic[] = {0, 3,  1, 5,  0, 6,  0, 9,  1, 10,  0, 12,  -1};
+
+    // Ordering
+    reset();
+    swt_start(&timers[0], 5, SWT_ONE_SHOT);
+    swt_start(&timers[1], 3, SWT_ONE_SHOT);
+    swt_start(&timers[2], 5, SWT_ONE_SHOT);
+    swt_start(&timers[3], 1, SWT_ONE_SHOT);
+    run(8);
+    expect("ordering", ordering);
+    same_tick_order();
+
+    reset();
+    swt_start(&timers[0], 3, 3);
+    swt_start(&timers[1], 5, 5);
+    run(12);
+    expect("periodic", periodic);
+
+    reset();
+    swt_start(&timers[0], 0, SWT_ONE_SHOT);
+    run(1);
+    if(fires != 1 || fired_tick[0] != 1){
+        printf("FAIL: 0 ticks did not fire on the next tick\n");
+        failures++;
+    }
+
+    // Cancellation
+    reset();
+    swt_start(&timers[0], 2, SWT_ONE_SHOT);
+    swt_start(&timers[1], 6, SWT_ONE_SHOT);
+    swt_start(&timers[2], 9, SWT_ONE_SHOT);
+    run(1);
+    swt_cancel(&timers[1]);
+    run(10);
+    expect("cancel middle", cancel_middle);
+
+    reset();
+    swt_start(&timers[0], 2, SWT_ONE_SHOT);
+    swt_start(&timers[1], 6, SWT_ONE_SHOT);
+    swt_start(&timers[2], 9, SWT_ONE_SHOT);
+    run(1);
+    swt_cancel(&timers[0]);
+    run(10);
+    expect("cancel first", cancel_first);
+
+    reset();
+    swt_start(&timers[0], 2, SWT_ONE_SHOT);
+    swt_start(&timers[1], 6, SWT_ONE_SHOT);
+    swt_start(&timers[2], 9, SWT_ONE_SHOT);
+    run(1);
+    swt_cancel(&timers[2]);
+    run(10);
+    expect("cancel last", cancel_last);
+
+    reset();
+    swt_start(&timers[0], 2, SWT_ONE_SHOT);
+    swt_start(&timers[1], 4, SWT_ONE_SHOT);
+    swt_start(&timers[0], 10, SWT_ONE_SHOT);
+    run(12);
+    expect("restart", restart);
+
+    reset();
+    swt_start(&timers[0], 1, 1);
+    run(2);
+    swt_tick();                         // Fired and back in the list
+    swt_cancel(&timers[0]);
+    if(swt_running(&timers[0]) || swt_fired(&timers[0]) || swt_head){
+        printf("FAIL: cancel left a periodic timer running or fired\n");
+        failures++;
+    }
+
+    // Wrap-around: 70000 ticks is past 0xFFFF. The long timer fires
+    // once, on its tick, and the periodic one every 1000 ticks.
+    reset();
+    swt_start(&timers[0], 0xFFFF, SWT_ONE_SHOT);
+    swt_start(&timers[1], 1000, 1000);
+    run(70000);
+    if(fire_count[0] != 1 || last_tick[0] != 0xFFFF ||
+       fire_count[1] != 70 || last_tick[1] != 70000){
+        printf("FAIL: wrap-around, long timer %u at %u, periodic %u last at %u\n",
+               fire_count[0], last_tick[0], fire_count[1], last_tick[1]);
+        failures++;
+    }
+
+    // Interrupt state
+    reset();
+    __disable_interrupt();
+    swt_start(&timers[0], 5, SWT_ONE_SHOT);
+    swt_cancel(&timers[0]);
+    if(gie){
+        printf("FAIL: interrupts enabled by swt_start or swt_cancel\n");
+        failures++;
+    }
+    __enable_interrupt();
+    swt_start(&timers[0], 5, SWT_ONE_SHOT);
+    swt_cancel(&timers[0]);
+    if(!gie){
+        printf("FAIL: interrupts left off by swt_start or swt_cancel\n");
+        failures++;
+    }
+
+    if(failures){
+        printf("%u failed\n", failures);
+        return 1;
+    }
+    printf("software timer tests passed\n");
+    return 0;
+}
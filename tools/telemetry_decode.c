@@ -0,0 +1,476 @@
+/*
+ * telemetry_decode.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host tool that reads the binary telemetry stream from the car's USB
+ *  UART (or a file captured from it), checks each frame and writes the
+ *  status frames as CSV on stdout. Frames that fail COBS or CRC checks,
+ *  and gaps in the sequence numbers, are counted on stderr.
+ *
+ *  The same UART carries text: USB command replies and mirrored command
+ *  lines. A block between delimiters that is all printable text is
+ *  counted as text, not as a bad frame. To resync with captures where
+ *  text runs straight into a frame (firmware before the leading 0x00,
+ *  or a full mirror), a block that fails is tried again from just after
+ *  each '\n' in the text it starts with, and a text run too long for the block buffer keeps
+ *  only its newest bytes, since a frame can only be at the end.
+ *
+ *  Capture frames (^0000G) are gathered and each capture is written to
+ *  capture_<n>.csv in the current directory, with its time in us from
+ *  the trigger rebuilt from the ADC slot counts, and a capture_<n>.gp
+ *  gnuplot script that plots it (gnuplot -p capture_<n>.gp).
+ *
+ *  Build and run on Linux:
+ *    cc -O2 -o telemetry_decode telemetry_decode.c
+ *    stty -F /dev/ttyUSB0 115200 raw -echo
+ *    ./telemetry_decode /dev/ttyUSB0 > run.csv
+ *
+ *  Functions included:
+ *    - crc16: CRC-16/CCITT-FALSE, same as the firmware.
+ *    - cobs_decode: Undoes the COBS encoding of one frame.
+ *    - frame_status: Prints one status frame as a CSV row.
+ *    - frame_latency: Prints a command latency frame on stderr.
+ *    - frame_tasks: Prints a scheduler task frame on stderr.
+ *    - frame_isr: Prints one ISR's profile on stderr.
+ *    - frame_battery: Prints a low battery or recovery event on stderr.
+ *    - frame_edge: Prints a stop on the line and its latency on stderr.
+ *    - frame_capture: Collects the records of a raw ADC capture.
+ *    - is_text: Tells whether a block is printable text.
+ *    - block_done: Decodes a block as a frame, text, or text then frame.
+ *    - capture_write: Writes a collected capture as CSV and a plot script.
+ *    - main: Splits the input at 0x00 delimiters and decodes frames.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "../telemetry.h"
+
+#define CHUNK (256)
+#define CAP_MAX (65536)
+
+typedef struct {
+    unsigned short left;
+    unsigned short right;
+    unsigned short thumb;
+    unsigned char have;
+    long time;                          // us from the trigger record
+} cap_entry;
+
+static unsigned long frames_good;
+static unsigned long frames_bad;
+static unsigned long text_bytes;
+static unsigned long frames_lost;
+static unsigned int next_seq;
+static int have_seq;
+
+static cap_entry cap[CAP_MAX];
+static int cap_id = -1;                 // Capture being collected
+static unsigned int cap_total;
+static unsigned int cap_pre;
+static unsigned int cap_got;
+static unsigned int cap_slot_us;
+static unsigned int cap_source;
+static unsigned int cap_level;
+static unsigned long cap_trig_us;
+
+static unsigned int get_u16(const unsigned char *p){
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned long get_u32(const unsigned char *p){
+    return get_u16(p) | ((unsigned long)get_u16(p + 2) << 16);
+}
+
+static unsigned int crc16(const unsigned char *data, unsigned int length, unsigned int crc){
+    int bit;
+
+    while(length--){
+        crc ^= (unsigned int)*data++ << 8;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        crc &= 0xFFFF;
+    }
+    return crc;
+}
+
+// Returns decoded length, or -1 if the block is not valid COBS
+static int cobs_decode(const unsigned char *src, int length, unsigned char *dest, int max){
+    int in = 0;
+    int out = 0;
+    int code;
+    int i;
+
+    while(in < length){
+        code = src[in++];
+        if(code == 0 || in + code - 1 > length){
+            return -1;
+        }
+        for(i = 1; i < code; i++){
+            if(out >= max){
+                return -1;
+            }
+            dest[out++] = src[in++];
+        }
+        if(code != 0xFF && in < length){
+            if(out >= max){
+                return -1;
+            }
+            dest[out++] = 0;
+        }
+    }
+    return out;
+}
+
+static void frame_status(const unsigned char *raw){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+
+    printf("%u,%lu,%u,%u,%u,%c,%c,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+           get_u16(raw + TLM_OFF_SEQ), get_u32(raw + TLM_OFF_TIME),
+           get_u16(p + TLM_ST_LEFT), get_u16(p + TLM_ST_RIGHT),
+           get_u16(p + TLM_ST_THUMB),
+           p[TLM_ST_BLSTATE] ? p[TLM_ST_BLSTATE] : '-',
+           p[TLM_ST_MOVEMENT] ? p[TLM_ST_MOVEMENT] : '-',
+           get_u16(p + TLM_ST_R_FORWARD), get_u16(p + TLM_ST_R_REVERSE),
+           get_u16(p + TLM_ST_L_FORWARD), get_u16(p + TLM_ST_L_REVERSE),
+           get_u16(p + TLM_ST_IOT_HIGH), get_u16(p + TLM_ST_IOT_OVERRUN),
+           get_u16(p + TLM_ST_USB_OVERRUN), get_u16(p + TLM_ST_BRIDGE_DROP),
+           get_u16(p + TLM_ST_SKIPPED), get_u16(p + TLM_ST_MOTION_QUEUE),
+           get_u16(p + TLM_ST_MOTION_OVER), get_u16(p + TLM_ST_BOOT_MS),
+           get_u16(p + TLM_ST_SLEEP), get_u16(p + TLM_ST_WAKE_AVG),
+           get_u16(p + TLM_ST_WAKE_MAX), get_u16(p + TLM_ST_ADC_MISSED),
+           get_u16(p + TLM_ST_LINE_AGE), get_u16(p + TLM_ST_FILTER_MAX),
+           get_u16(p + TLM_ST_AMB_LEFT), get_u16(p + TLM_ST_AMB_RIGHT),
+           p[TLM_ST_IR_MODE], get_u16(p + TLM_ST_BAT_MV), p[TLM_ST_BAT_LOW]);
+}
+
+static void latency_set(const char *name, const unsigned char *p){
+    fprintf(stderr, "%s: n=%u min=%lu avg=%lu max=%lu p50<=%lu p95<=%lu p99<=%lu us\n",
+            name, get_u16(p + TLM_LS_COUNT), get_u32(p + TLM_LS_MIN),
+            get_u32(p + TLM_LS_AVG), get_u32(p + TLM_LS_MAX),
+            get_u32(p + TLM_LS_P50), get_u32(p + TLM_LS_P95), get_u32(p + TLM_LS_P99));
+}
+
+// Kept off stdout so the CSV stays one row type
+static void frame_latency(const unsigned char *raw){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+
+    fprintf(stderr, "latency at %lu ms, %u stamps lost\n",
+            get_u32(raw + TLM_OFF_TIME), get_u16(p + TLM_LAT_LOST));
+    latency_set("  rx to applied", p + TLM_LAT_TOTAL);
+    latency_set("  rx to parsed ", p + TLM_LAT_PARSE);
+}
+
+// Same order as the task table in scheduler.c
+static const char *task_names[] = {
+    "bootIOT", "movement_machine", "Serial_Process",
+    "Telemetry_Process", "Seconds_Process", "Display_Process",
+    "Calibration_Process", "Battery_Process"
+};
+
+static void frame_tasks(const unsigned char *raw, int size){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+    int i;
+
+    fprintf(stderr, "tasks at %lu ms\n", get_u32(raw + TLM_OFF_TIME));
+    for(i = 0; (i + 1) * TLM_TASK_LEN <= size; i++, p += TLM_TASK_LEN){
+        fprintf(stderr, "  %-18s runs=%lu avg=%u worst=%u us overruns=%u late=%u\n",
+                i < (int)(sizeof(task_names) / sizeof(task_names[0])) ? task_names[i] : "?",
+                get_u32(p + TLM_TK_RUNS), get_u16(p + TLM_TK_AVG),
+                get_u16(p + TLM_TK_WORST), get_u16(p + TLM_TK_OVERRUNS),
+                get_u16(p + TLM_TK_LATE));
+    }
+}
+
+// Same order as ISR_PROF_* in isrprof.h
+static const char *isr_names[] = {
+    "eUSCI_A0", "eUSCI_A1", "Timer0_B0", "Timer0_B1", "ADC", "Port2", "Port4"
+};
+
+static void isr_histogram(const char *name, const unsigned char *p, unsigned int width){
+    int i;
+
+    fprintf(stderr, "    %s (%u us buckets):", name, width);
+    for(i = 0; i < 16; i++){
+        fprintf(stderr, " %u", get_u16(p + 2 * i));
+    }
+    fprintf(stderr, "\n");
+}
+
+static void frame_isr(const unsigned char *raw){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+    unsigned int id = p[TLM_IS_ID];
+
+    fprintf(stderr, "isr %s: n=%u worst=%u us nested=%u late=%u us\n",
+            id < sizeof(isr_names) / sizeof(isr_names[0]) ? isr_names[id] : "?",
+            get_u16(p + TLM_IS_COUNT), get_u16(p + TLM_IS_WORST),
+            get_u16(p + TLM_IS_NESTED), get_u16(p + TLM_IS_LATE));
+    isr_histogram("run  ", p + TLM_IS_DURATION, 8);
+    isr_histogram("since", p + TLM_IS_INTERVAL, 1024);
+}
+
+static void frame_battery(const unsigned char *raw){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+
+    fprintf(stderr, "battery %s at %lu ms: %u mV, 5V0 %u mV, 3V3 %u mV, scale %u/1024\n",
+            p[TLM_BAT_LOW] ? "low" : "ok", get_u32(raw + TLM_OFF_TIME),
+            get_u16(p + TLM_BAT_MV), get_u16(p + TLM_BAT_5_0),
+            get_u16(p + TLM_BAT_3_3), get_u16(p + TLM_BAT_COMP));
+}
+
+static void frame_edge(const unsigned char *raw){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+    unsigned int latency = get_u16(p + TLM_ED_LATENCY);
+
+    fprintf(stderr, "line stop at %lu ms by %s, ",
+            get_u32(raw + TLM_OFF_TIME), p[TLM_ED_SOURCE] ? "main loop" : "ADC ISR");
+    if(p[TLM_ED_DETECTOR] == 0xFF || latency == 0xFFFF){
+        fprintf(stderr, "no crossing seen");
+    } else {
+        fprintf(stderr, "%s crossed at %lu us, %u us to brake",
+                p[TLM_ED_DETECTOR] ? "right" : "left", get_u32(p + TLM_ED_SAMPLE_US), latency);
+    }
+    fprintf(stderr, "; ISR brakes %u min %u max %u us; crossings left %u right %u\n",
+            get_u16(p + TLM_ED_BRAKES), get_u16(p + TLM_ED_MIN), get_u16(p + TLM_ED_MAX),
+            get_u16(p + TLM_ED_CROSS_L), get_u16(p + TLM_ED_CROSS_R));
+}
+
+static unsigned int cap_slots(unsigned int i){
+    return cap[i].left >> 12;
+}
+
+//-----------------------------------------------------------------
+// Times are rebuilt outwards from the trigger record. A missing
+// frame leaves a gap in the rows and takes its slot counts with
+// it, so the times past the gap come out short.
+//-----------------------------------------------------------------
+static void capture_write(void){
+    char name[32];
+    FILE *out;
+    unsigned int i;
+
+    if(cap_id < 0 || !cap_got || cap_pre >= cap_total){
+        cap_id = -1;
+        return;
+    }
+    cap[cap_pre].time = 0;
+    for(i = cap_pre + 1; i < cap_total; i++){
+        cap[i].time = cap[i - 1].time + (long)cap_slots(i) * cap_slot_us;
+    }
+    for(i = cap_pre; i > 0; i--){
+        cap[i - 1].time = cap[i].time - (long)cap_slots(i) * cap_slot_us;
+    }
+
+    snprintf(name, sizeof(name), "capture_%d.csv", cap_id);
+    if(!(out = fopen(name, "w"))){
+        perror(name);
+        cap_id = -1;
+        return;
+    }
+    fprintf(out, "record,time_us,left,right,thumb,led_off,slots\n");
+    for(i = 0; i < cap_total; i++){
+        if(cap[i].have){
+            fprintf(out, "%u,%ld,%u,%u,%u,%u,%u\n", i, cap[i].time,
+                    cap[i].left & 0x0FFF, cap[i].right & 0x0FFF, cap[i].thumb & 0x0FFF,
+                    cap[i].right >> 15, cap_slots(i));
+        }
+    }
+    fclose(out);
+    fprintf(stderr, "capture %d: %u of %u records, %u before the trigger (%s",
+            cap_id, cap_got, cap_total, cap_pre,
+            cap_source == 0xFF ? "manual" : cap_source ? "right" : "left");
+    if(cap_source != 0xFF){
+        fprintf(stderr, " through %u", cap_level);
+    }
+    fprintf(stderr, ") at %lu us, %u us slots -> %s\n", cap_trig_us, cap_slot_us, name);
+
+    snprintf(name, sizeof(name), "capture_%d.gp", cap_id);
+    if((out = fopen(name, "w"))){
+        fprintf(out, "set datafile separator ','\n"
+                     "set key autotitle columnhead\n"
+                     "set xlabel 'us from trigger'\n"
+                     "set ylabel 'raw ADC, 12 bit'\n"
+                     "set yrange [0:4095]\n"
+                     "plot 'capture_%d.csv' using 2:3 with linespoints, '' using 2:4 with linespoints, "
+                     "'' using 2:5 with lines\n", cap_id);
+        fclose(out);
+    }
+    cap_id = -1;
+}
+
+static void frame_capture(const unsigned char *raw, int size){
+    const unsigned char *p = raw + TLM_HEADER_LEN;
+    const unsigned char *r;
+    unsigned int first = get_u16(p + TLM_CAP_FIRST);
+    unsigned int i;
+
+    if(cap_id != p[TLM_CAP_ID]){
+        capture_write();                // Previous one never finished
+        memset(cap, 0, sizeof(cap));
+        cap_id = p[TLM_CAP_ID];
+        cap_total = get_u16(p + TLM_CAP_TOTAL);
+        cap_pre = get_u16(p + TLM_CAP_PRE);
+        cap_slot_us = get_u16(p + TLM_CAP_SLOT_US);
+        cap_source = p[TLM_CAP_SOURCE];
+        cap_level = get_u16(p + TLM_CAP_LEVEL);
+        cap_trig_us = get_u32(p + TLM_CAP_TRIG_US);
+        cap_got = 0;
+    }
+    for(i = 0; TLM_CAP_RECORDS + (int)(i + 1) * TLM_CAP_REC_LEN <= size; i++){
+        if(first + i >= cap_total || cap[first + i].have){
+            continue;
+        }
+        r = p + TLM_CAP_RECORDS + i * TLM_CAP_REC_LEN;
+        cap[first + i].left = get_u16(r + TLM_CR_LEFT);
+        cap[first + i].right = get_u16(r + TLM_CR_RIGHT);
+        cap[first + i].thumb = get_u16(r + TLM_CR_THUMB);
+        cap[first + i].have = 1;
+        cap_got++;
+    }
+    if(cap_got == cap_total){
+        capture_write();
+    }
+}
+
+// Returns 0 if the block is not a good frame
+static int frame(const unsigned char *block, int length){
+    unsigned char raw[TLM_MAX_RAW];
+    unsigned int seq;
+    int size;
+
+    size = cobs_decode(block, length, raw, sizeof(raw));
+    if(size < TLM_HEADER_LEN + TLM_CRC_LEN ||
+       crc16(raw, size - TLM_CRC_LEN, TLM_CRC_START) != get_u16(raw + size - TLM_CRC_LEN)){
+        return 0;
+    }
+    seq = get_u16(raw + TLM_OFF_SEQ);
+    if(have_seq && seq != next_seq){
+        frames_lost += (seq - next_seq) & 0xFFFF;
+    }
+    next_seq = (seq + 1) & 0xFFFF;
+    have_seq = 1;
+    frames_good++;
+
+    size -= TLM_HEADER_LEN + TLM_CRC_LEN;
+    switch(raw[TLM_OFF_TYPE]){
+        case TLM_TYPE_STATUS:
+            if(size >= TLM_STATUS_LEN){
+                frame_status(raw);
+            }
+            break;
+        case TLM_TYPE_ISR:
+            if(size >= TLM_ISR_LEN){
+                frame_isr(raw);
+            }
+            break;
+        case TLM_TYPE_TASKS:
+            frame_tasks(raw, size);
+            break;
+        case TLM_TYPE_BATTERY:
+            if(size >= TLM_BATTERY_LEN){
+                frame_battery(raw);
+            }
+            break;
+        case TLM_TYPE_EDGE:
+            if(size >= TLM_EDGE_LEN){
+                frame_edge(raw);
+            }
+            break;
+        case TLM_TYPE_CAPTURE:
+            if(size >= TLM_CAP_RECORDS){
+                frame_capture(raw, size);
+            }
+            break;
+        case TLM_TYPE_LATENCY:
+            if(size >= TLM_LATENCY_LEN){
+                frame_latency(raw);
+            }
+            break;
+        default:
+            break;
+    }
+    fflush(stdout);
+    return 1;
+}
+
+static int is_text(const unsigned char *block, int length){
+    int i;
+
+    for(i = 0; i < length; i++){
+        if((block[i] < 0x20 || block[i] > 0x7E) &&
+           block[i] != '\r' && block[i] != '\n' && block[i] != '\t'){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void block_done(const unsigned char *block, int length){
+    int start;
+
+    if(frame(block, length)){
+        return;
+    }
+    if(is_text(block, length)){
+        text_bytes += length;
+        return;
+    }
+    // Frame bytes can be '\n' too, so try after each one in the text
+    for(start = 0; start < length && is_text(block + start, 1); start++){
+        if(block[start] == '\n' && frame(block + start + 1, length - start - 1)){
+            text_bytes += start + 1;
+            return;
+        }
+    }
+    frames_bad++;
+}
+
+int main(int argc, char *argv[]){
+    unsigned char chunk[CHUNK];
+    unsigned char block[TLM_MAX_FRAME * 2];
+    int length = 0;
+    size_t got;
+    size_t i;
+    FILE *in = stdin;
+
+    if(argc > 1 && !(in = fopen(argv[1], "rb"))){
+        perror(argv[1]);
+        return 1;
+    }
+    printf("seq,time_ms,left,right,thumb,bl_state,movement,"
+           "r_forward,r_reverse,l_forward,l_reverse,"
+           "iot_rx_high,iot_rx_overrun,usb_rx_overrun,bridge_dropped,skipped,"
+           "motion_queue,motion_overflow,iot_boot_ms,"
+           "sleep_permille,wake_avg_us,wake_max_us,"
+           "adc_missed,line_age_us,filter_max_us,ambient_left,ambient_right,ir_mode,"
+           "bat_mv,bat_low\n");
+
+    while((got = fread(chunk, 1, sizeof(chunk), in)) > 0){
+        for(i = 0; i < got; i++){
+            if(chunk[i] != TLM_DELIMITER){
+                if(length == (int)sizeof(block)){
+                    // Only text runs this long, keep the half a frame could be in
+                    memmove(block, block + TLM_MAX_FRAME, TLM_MAX_FRAME);
+                    length = TLM_MAX_FRAME;
+                    text_bytes += TLM_MAX_FRAME;
+                }
+                block[length++] = chunk[i];
+                continue;
+            }
+            if(length){
+                block_done(block, length);
+            }
+            length = 0;
+        }
+    }
+    capture_write();                    // Stream ended part way through a capture
+    fprintf(stderr, "frames: %lu good, %lu bad, %lu lost, %lu text bytes\n",
+            frames_good, frames_bad, frames_lost, text_bytes);
+    return 0;
+}
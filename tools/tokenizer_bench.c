@@ -0,0 +1,247 @@
+/*
+ * tokenizer_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  Host benchmark of bytes-to-actuation latency for IOT commands, in
+ *  passes through the main loop. The ESP32's bytes land in iot_rx_ring
+ *  at 115200 baud, one every 86.8 us, while the main loop makes one
+ *  pass every 100, 500 or 2000 us and calls the command code once.
+ *
+ *    old: iot_commands as it was at the start of the project, which
+ *         looks at one byte of the receive buffer per call and acts
+ *         on a command in the call that sees its '\r'.
+ *    new: iot_link_rx and iot_token as they are now, which drain the
+ *         ring with ring_peek every call, strip the +IPD header and
+ *         dispatch each command as soon as its '\r' is in.
+ *
+ *  Both are reduced to their byte handling; "actuation" is the call
+ *  where the old opcode chain or iot_dispatch would run. The ring is
+ *  the real ringbuf.c. For each stream of ESP32 output the passes are
+ *  counted from its first byte until its last command acts, and from
+ *  the '\r' of each command until it acts (the worst one is shown).
+ *
+ *  Build and run on Linux, from tools:
+ *    cc -O2 -Wall -I.. -o tokenizer_bench tokenizer_bench.c ../ringbuf.c
+ *    ./tokenizer_bench
+ *
+ *  Functions included:
+ *    - old_commands: One byte per call, the original tokenizer.
+ *    - new_commands: Drains the ring, +IPD header then tokenizer.
+ *    - run: Replays one payload against one tokenizer.
+ *    - main: Prints the table for a few loop pass times.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "ringbuf.h"
+#include "macros.h"
+
+#define BYTE_NS         (86806L)    // 10 bits at 115200
+#define CMD_SIZE        (16)
+#define MAX_CMDS        (8)
+
+typedef struct {
+    const char *name;
+    const char *bytes;
+} payload;
+
+static const payload payloads[] = {
+    {"one move",        "+IPD,0,9:^1234F5\r\n"},
+    {"three in one",    "+IPD,0,27:^1234F5\r\n^1234R2\r\n^1234Q\r\n"},
+    {"after SEND OK",   "\r\nSEND OK\r\n+IPD,0,9:^1234B3\r\n"}
+};
+
+static const long pass_us[] = {100, 500, 2000};
+
+static char rx_storage[IOT_RX_SIZE];
+static ring_buf rx;
+static int acted;                       // Commands acted on so far
+
+// old_commands state
+static char old_caret;
+static char old_cmd[CMD_SIZE];
+static unsigned int old_len;
+
+// new_commands state
+static char in_payload;
+static unsigned int remaining;
+static char line[CMD_SIZE * 2];
+static unsigned int line_len;
+static char in_cmd;
+static unsigned int cmd_len;
+
+//-----------------------------------------------------------------
+// The original loop: a byte is taken per call, the '\r' is looked
+// at but left for the next call, which drops it.
+//-----------------------------------------------------------------
+static void old_commands(void){
+    char c;
+
+    if(!ring_count(&rx)){
+        return;
+    }
+    c = ring_peek_at(&rx, 0);
+    if(!old_caret){
+        ring_consume(&rx, 1);
+        if(c == '^'){
+            old_caret = 1;
+        }
+    } else if(old_caret == 1){
+        if(c != '\r'){
+            ring_consume(&rx, 1);
+            if(old_len < sizeof(old_cmd)){
+                old_cmd[old_len++] = c;
+            }
+        } else {
+            old_caret = 2;
+        }
+    }
+    if(old_caret == 2){
+        acted++;
+        old_caret = 0;
+        old_len = 0;
+    }
+}
+
+static void new_token(char c){
+    if(c == '^'){
+        in_cmd = TRUE;
+        cmd_len = 0;
+        return;
+    }
+    if(!in_cmd){
+        return;
+    }
+    if(c == '\r' || c == '\n'){
+        in_cmd = FALSE;
+        acted++;
+        return;
+    }
+    if(cmd_len < CMD_SIZE - 1){
+        cmd_len++;
+    } else {
+        in_cmd = FALSE;
+    }
+}
+
+static void new_commands(void){
+    const char *data;
+    unsigned int length;
+    unsigned int i;
+    char c;
+
+    while((length = ring_peek(&rx, &data)) != 0){
+        if(in_payload){
+            if(length > remaining){
+                length = remaining;
+            }
+            for(i = 0; i < length; i++){
+                new_token(data[i]);
+            }
+            ring_consume(&rx, length);
+            remaining -= length;
+            in_payload = remaining != 0;
+            continue;
+        }
+        for(i = 0; i < length && !in_payload; i++){
+            c = data[i];
+            if(c == '\n' || c == '\r'){
+                line_len = 0;
+            } else if(c == ':' && line_len > 5 && !strncmp(line, "+IPD,", 5)){
+                line[line_len] = 0;
+                remaining = 0;
+                sscanf(line, "+IPD,%*u,%u", &remaining);
+                in_payload = remaining != 0;
+                line_len = 0;
+            } else if(line_len < sizeof(line) - 1){
+                line[line_len++] = c;
+            }
+        }
+        ring_consume(&rx, i);
+    }
+}
+
+//-----------------------------------------------------------------
+// Bytes go into the ring as their stop bits end, the command code
+// runs at the end of each pass. Returns the passes from the start of
+// the payload until its last command has acted, and in *after_last
+// the most passes any command took once its '\r' was in.
+//-----------------------------------------------------------------
+static long run(const char *bytes, void (*commands)(void), long pass, long *after_last){
+    long length = strlen(bytes);
+    long end_at[MAX_CMDS];              // Index of each command's '\r'
+    long end_pass[MAX_CMDS];            // Pass it arrived in
+    long sent = 0;
+    long now = 0;
+    long passes = 0;
+    int cmds = 0;
+    int ended = 0;
+    int before;
+    int caret = FALSE;
+    int i;
+
+    for(i = 0; i < length && cmds < MAX_CMDS; i++){
+        if(bytes[i] == '^'){
+            caret = TRUE;
+        } else if(bytes[i] == '\r' && caret){
+            end_at[cmds++] = i;
+            caret = FALSE;
+        }
+    }
+
+    ring_init(&rx, rx_storage, sizeof(rx_storage));
+    acted = 0;
+    old_caret = 0;
+    old_len = 0;
+    in_payload = FALSE;
+    line_len = 0;
+    in_cmd = FALSE;
+    *after_last = 0;
+
+    while(passes < 100000 && (sent < length || acted < cmds)){
+        now += pass * 1000L;
+        while(sent < length && (sent + 1) * BYTE_NS <= now){
+            ring_put(&rx, bytes[sent]);
+            if(ended < cmds && sent == end_at[ended]){
+                end_pass[ended++] = passes;
+            }
+            sent++;
+        }
+        before = acted;
+        commands();
+        passes++;
+        for(i = before; i < acted; i++){
+            if(passes - end_pass[i] > *after_last){
+                *after_last = passes - end_pass[i];
+            }
+        }
+    }
+    return passes;
+}
+
+int main(void){
+    unsigned int p;
+    unsigned int i;
+    long old_total;
+    long new_total;
+    long old_last;
+    long new_last;
+
+    printf("115200 baud, passes through the main loop until the command acts\n");
+    printf("pass us  stream         old: from start  from '\\r'  new: from start  from '\\r'\n");
+    for(p = 0; p < sizeof(pass_us) / sizeof(pass_us[0]); p++){
+        for(i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++){
+            old_total = run(payloads[i].bytes, old_commands, pass_us[p], &old_last);
+            new_total = run(payloads[i].bytes, new_commands, pass_us[p], &new_last);
+            printf("%7ld  %-14s  %14ld  %9ld  %14ld  %9ld\n", pass_us[p], payloads[i].name,
+                   old_total, old_last, new_total, new_last);
+        }
+    }
+    return 0;
+}
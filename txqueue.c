@@ -0,0 +1,89 @@
+/*
+ * txqueue.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Description:
+ *  ------------
+ *  This file contains the transmit descriptor queue used by both UARTs.
+ *  The main loop adds (pointer, length) descriptors and the transmit ISR
+ *  pulls one byte at a time from the oldest descriptor, moving straight
+ *  on to the next one so several commands can be sent back to back.
+ *
+ *  Functions included:
+ *    - tx_queue_init: Empties a queue.
+ *    - tx_queue_add: Adds a descriptor, returns FALSE if the queue is full.
+ *    - tx_queue_pending: Returns the number of descriptors not yet sent.
+ *    - tx_queue_next: ISR side, returns the next byte to load into TXBUF.
+ *
+ */
+
+
+#include "txqueue.h"
+#include "macros.h"
+
+#define TX_QUEUE_MASK (TX_QUEUE_DEPTH - 1)
+
+void tx_queue_init(tx_queue *queue){
+    queue->head = BEGINNING;
+    queue->tail = BEGINNING;
+    queue->sent = 0;
+    queue->dropped = 0;
+}
+
+char tx_queue_add(tx_queue *queue, const char *data, unsigned int length,
+                  volatile unsigned char *done){
+    unsigned int head = queue->head;
+    tx_desc *desc;
+
+    if(head - queue->tail >= TX_QUEUE_DEPTH){
+        queue->dropped++;
+        return FALSE;
+    }
+    if(done){
+        *done = FALSE;
+    }
+    desc = &queue->desc[head & TX_QUEUE_MASK];
+    desc->data = data;
+    desc->length = length;
+    desc->done = done;
+    queue->head = head + 1;             // Publish only after it is filled in
+    return TRUE;
+}
+
+unsigned int tx_queue_pending(const tx_queue *queue){
+    return queue->head - queue->tail;
+}
+
+//-----------------------------------------------------------------
+// Called from the TX interrupt. Returns FALSE when there is nothing
+// left so the ISR can turn its TX interrupt off. The done flag is set
+// as the last byte goes into TXBUF, the caller may reuse its buffer
+// from then on.
+//-----------------------------------------------------------------
+char tx_queue_next(tx_queue *queue, char *c){
+    unsigned int tail = queue->tail;
+    tx_desc *desc;
+
+    while(tail != queue->head){
+        desc = &queue->desc[tail & TX_QUEUE_MASK];
+        if(queue->sent < desc->length){
+            *c = desc->data[queue->sent++];
+            if(queue->sent >= desc->length){
+                if(desc->done){
+                    *desc->done = TRUE;
+                }
+                queue->sent = 0;
+                queue->tail = tail + 1;
+            }
+            return TRUE;
+        }
+        if(desc->done){                 // Zero length descriptor
+            *desc->done = TRUE;
+        }
+        queue->sent = 0;
+        queue->tail = ++tail;
+    }
+    return FALSE;
+}
@@ -0,0 +1,42 @@
+/*
+ * txqueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *  Descriptor queue feeding a UART transmit interrupt. Each descriptor
+ *  points at the caller's bytes (usually a const string in FRAM), nothing
+ *  is copied and nothing is cleared after it is sent.
+ */
+
+#ifndef TXQUEUE_H_
+#define TXQUEUE_H_
+
+#define TX_QUEUE_DEPTH (8)      // Must be a power of two
+
+typedef struct {
+    const char *data;                   // First byte to send
+    unsigned int length;                // Number of bytes to send
+    volatile unsigned char *done;       // Set TRUE once sent, may be NULL
+} tx_desc;
+
+//------------------------------------------------------------------------------
+// head is stored by the main loop when a descriptor is added, tail and
+// sent are only touched by the transmit ISR. The data behind a descriptor
+// must stay valid until its done flag is set.
+//------------------------------------------------------------------------------
+typedef struct {
+    tx_desc desc[TX_QUEUE_DEPTH];
+    volatile unsigned int head;         // Next free descriptor
+    volatile unsigned int tail;         // Descriptor being sent
+    unsigned int sent;                  // Bytes of desc[tail] already sent
+    volatile unsigned int dropped;      // Descriptors refused, queue full
+} tx_queue;
+
+void tx_queue_init(tx_queue *queue);
+char tx_queue_add(tx_queue *queue, const char *data, unsigned int length,
+                  volatile unsigned char *done);
+unsigned int tx_queue_pending(const tx_queue *queue);
+char tx_queue_next(tx_queue *queue, char *c);
+
+#endif /* TXQUEUE_H_ */
@@ -23,6 +23,7 @@
  *    - turn: Turns in place using differential drive.
  *    - turn_left: Executes a left turn.
  *    - turn_right: Executes a right turn.
+ *    - set_motor_speeds: Sets both wheels from signed percent duty.
  *
  */
 
@@ -33,6 +34,8 @@
 #include  "LCD.h"
 #include  "ports.h"
 #include "macros.h"
+#include "adc.h"
+#include "battery.h"
 
 
 void turn_off_motors(void){
@@ -44,52 +47,52 @@ void turn_off_motors(void){
 
 void turn_on_forward(void){
     turn_off_motors(); // Call turn_off function to turn off the motors
-    LEFT_FORWARD_SPEED = LEFT_WHEEL_SLOW;
-    RIGHT_FORWARD_SPEED = RIGHT_WHEEL_SLOW;
+    LEFT_FORWARD_SPEED = motor_duty(LEFT_WHEEL_SLOW);
+    RIGHT_FORWARD_SPEED = motor_duty(RIGHT_WHEEL_SLOW);
 }
 
 void forward_fast(void) {
     turn_off_motors();
-    RIGHT_FORWARD_SPEED = FAST;
-    LEFT_FORWARD_SPEED = MEDIUM;
+    RIGHT_FORWARD_SPEED = motor_duty(FAST);
+    LEFT_FORWARD_SPEED = motor_duty(MEDIUM);
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
     LEFT_REVERSE_SPEED = WHEEL_OFF;
 }
 
 void forward_medium(void) {
     turn_off_motors();
-    RIGHT_FORWARD_SPEED = MEDIUM;
-    LEFT_FORWARD_SPEED = MEDIUM;
+    RIGHT_FORWARD_SPEED = motor_duty(MEDIUM);
+    LEFT_FORWARD_SPEED = motor_duty(MEDIUM);
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
     LEFT_REVERSE_SPEED = WHEEL_OFF;
 }
 
 void turn_on_reverse(void){
     turn_off_motors(); // Call turn_off function to turn off the motors
-    LEFT_REVERSE_SPEED = LEFT_WHEEL_SLOW;
-    RIGHT_REVERSE_SPEED = RIGHT_WHEEL_SLOW;
+    LEFT_REVERSE_SPEED = motor_duty(LEFT_WHEEL_SLOW);
+    RIGHT_REVERSE_SPEED = motor_duty(RIGHT_WHEEL_SLOW);
 }
 
 void reverse_fast(void) {
     turn_off_motors();
-    RIGHT_REVERSE_SPEED = FAST;
-    LEFT_REVERSE_SPEED = FAST;
+    RIGHT_REVERSE_SPEED = motor_duty(FAST);
+    LEFT_REVERSE_SPEED = motor_duty(FAST);
     RIGHT_FORWARD_SPEED = WHEEL_OFF;
     LEFT_FORWARD_SPEED = WHEEL_OFF;
 }
 
 void spin_clockwise(void){
     turn_off_motors();
-    RIGHT_FORWARD_SPEED = RIGHT_WHEEL_SLOW;
+    RIGHT_FORWARD_SPEED = motor_duty(RIGHT_WHEEL_SLOW);
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
-    LEFT_REVERSE_SPEED = LEFT_WHEEL_SLOW;
+    LEFT_REVERSE_SPEED = motor_duty(LEFT_WHEEL_SLOW);
     LEFT_FORWARD_SPEED = WHEEL_OFF;
 }
 
 void spin_clockwise_medium(void){
     turn_off_motors();
-    RIGHT_REVERSE_SPEED = MEDIUM;
-    LEFT_FORWARD_SPEED = MEDIUM;
+    RIGHT_REVERSE_SPEED = motor_duty(MEDIUM);
+    LEFT_FORWARD_SPEED = motor_duty(MEDIUM);
     RIGHT_FORWARD_SPEED = WHEEL_OFF;
     LEFT_REVERSE_SPEED = WHEEL_OFF;
 }
@@ -97,22 +100,22 @@ void spin_clockwise_medium(void){
 void spin_counterclockwise(void){
     turn_off_motors();
     RIGHT_FORWARD_SPEED = WHEEL_OFF;
-    RIGHT_REVERSE_SPEED = RIGHT_WHEEL_SLOW;
+    RIGHT_REVERSE_SPEED = motor_duty(RIGHT_WHEEL_SLOW);
     LEFT_REVERSE_SPEED = WHEEL_OFF;
-    LEFT_FORWARD_SPEED = LEFT_WHEEL_SLOW;
+    LEFT_FORWARD_SPEED = motor_duty(LEFT_WHEEL_SLOW);
 }
 
 void turn(void){
     turn_off_motors();
-    RIGHT_FORWARD_SPEED = RIGHT_WHEEL_SLOW;
+    RIGHT_FORWARD_SPEED = motor_duty(RIGHT_WHEEL_SLOW);
     LEFT_FORWARD_SPEED = WHEEL_OFF;
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
-    LEFT_REVERSE_SPEED = LEFT_WHEEL_SLOW;
+    LEFT_REVERSE_SPEED = motor_duty(LEFT_WHEEL_SLOW);
 }
 
 void turn_left(void){
     turn_off_motors();
-    RIGHT_FORWARD_SPEED = 6000;
+    RIGHT_FORWARD_SPEED = motor_duty(6000);
     LEFT_FORWARD_SPEED = WHEEL_OFF;
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
     LEFT_REVERSE_SPEED = WHEEL_OFF;
@@ -121,10 +124,36 @@ void turn_left(void){
 void turn_right(void){
     turn_off_motors();
     RIGHT_FORWARD_SPEED = WHEEL_OFF;
-    LEFT_FORWARD_SPEED = 6000;
+    LEFT_FORWARD_SPEED = motor_duty(6000);
     RIGHT_REVERSE_SPEED = WHEEL_OFF;
     LEFT_REVERSE_SPEED = WHEEL_OFF;
 }
 
-
-
+//-----------------------------------------------------------------
+// Sets both wheels in one place from a duty cycle in percent.
+// Positive drives forward, negative drives in reverse, 0 is off.
+// The other direction of each wheel is cleared first so a wheel is
+// never driven both ways at once. Like every duty in this file it
+// goes through motor_duty() for the battery voltage (battery.c).
+//-----------------------------------------------------------------
+void set_motor_speeds(int left, int right){
+    if(left > 100) left = 100;
+    if(left < -100) left = -100;
+    if(right > 100) right = 100;
+    if(right < -100) right = -100;
+
+    if(left >= 0){
+        LEFT_REVERSE_SPEED = WHEEL_OFF;
+        LEFT_FORWARD_SPEED = motor_duty(left * PWM_PER_PERCENT);
+    } else {
+        LEFT_FORWARD_SPEED = WHEEL_OFF;
+        LEFT_REVERSE_SPEED = motor_duty(-left * PWM_PER_PERCENT);
+    }
+    if(right >= 0){
+        RIGHT_REVERSE_SPEED = WHEEL_OFF;
+        RIGHT_FORWARD_SPEED = motor_duty(right * PWM_PER_PERCENT);
+    } else {
+        RIGHT_FORWARD_SPEED = WHEEL_OFF;
+        RIGHT_REVERSE_SPEED = motor_duty(-right * PWM_PER_PERCENT);
+    }
+}